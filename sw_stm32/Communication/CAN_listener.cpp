@@ -34,43 +34,39 @@
 #include "communicator.h"
 #include "uSD_handler.h"
 #include "signal_flight_event.h"
+#include "CAN_parameter_registry.h"
+#include "config_batch.h"
+#include "config_dump.h"
 
 #define CAN_Id_Send_Config_Value 0x12f
 
-ROM EEPROM_PARAMETER_ID parameter_list[] =
-    {
-	SENS_TILT_ROLL,
-	SENS_TILT_PITCH,
-	SENS_TILT_YAW,
-	PITOT_OFFSET,
-	PITOT_SPAN,
-	QNH_OFFSET,
-	MAG_AUTO_CALIB,
-	VARIO_TC,
-	VARIO_INT_TC,
-	WIND_TC,
-	MEAN_WIND_TC,
-	GNSS_CONFIGURATION,
-	ANT_BASELENGTH,
-	ANT_SLAVE_DOWN,
-	ANT_SLAVE_RIGHT,
-	VARIO_P_TC,
-	HORIZON
-    };
-
-#define PARAMETER_LIST_LENGTH (sizeof( parameter_list) / sizeof(EEPROM_PARAMETER_ID))
-#define PARAMETER_OFFSET 0x2000
+#define CMD_CONFIG_BATCH_BEGIN	0x2800 //!< stage all following "set" requests
+#define CMD_CONFIG_BATCH_COMMIT	0x2801 //!< write staged values, then notify all changes at once
+#define CONFIG_BATCH_TIMEOUT	2000   //!< ticks, an uncommitted batch is discarded after this time
+#define CMD_CONFIG_DUMP_ALL	0x2802 //!< send all CAN parameters as one burst
+#define CONFIG_DUMP_FRAME_WAIT	200    //!< ticks, the CAN pipeline is drained by the CAN task
+#define CMD_CAN_STATISTICS	0x2803 //!< send the CAN bus health counters
+
+//! write a staged value, @return change class on success
+static unsigned write_staged_parameter( unsigned index, float value)
+{
+  EEPROM_PARAMETER_ID id = CAN_PARAMETERS[ index].id;
+  bool success = write_EEPROM_value( id, value);
+  signal_logger_event( EEPROM_CONFIGURATION_CHANGED | (success ? (id<<8) + 0x10000 : (id<<8)) );
+  return success ? CAN_PARAMETERS[ index].change_class : CHANGE_NONE;
+}
+
+COMMON static config_batch_t < CAN_PARAMETER_COUNT> config_batch( CONFIG_BATCH_TIMEOUT);
 
 //! read or write EEPROM value
 //! @return true if value read successfully
 bool EEPROM_config_read_write( const CANpacket & p, float & return_value)
 {
-  uint16_t command = p.data_h[0];
-
-  if(( command < PARAMETER_OFFSET) || (command >= ( PARAMETER_OFFSET + PARAMETER_LIST_LENGTH)))
+  const CAN_parameter_t * parameter = find_CAN_parameter( p.data_h[0]);
+  if( parameter == 0)
     return false; // nothing for us ...
 
-  EEPROM_PARAMETER_ID id = parameter_list[ command - PARAMETER_OFFSET];
+  EEPROM_PARAMETER_ID id = parameter->id;
 
   switch( p.data_b[2])
   {
@@ -85,37 +81,17 @@ bool EEPROM_config_read_write( const CANpacket & p, float & return_value)
       {
 	float value = p.data_f[1];
 
+	if( config_batch.is_open( xTaskGetTickCount()))
+	  {
+	    config_batch.stage( parameter - CAN_PARAMETERS, value);
+	    return false; // written on commit
+	  }
+
 	bool success = write_EEPROM_value( id, value);
 	signal_logger_event( EEPROM_CONFIGURATION_CHANGED | (success ? (id<<8) + 0x10000 : (id<<8)) );
 
-	if( success)
-	  // we need to reset the algorithms because of a significant change
-	  {
-	    switch( id)
-	    {
-	      case VARIO_TC:
-	      case VARIO_P_TC:
-	      case VARIO_INT_TC:
-	      case WIND_TC:
-		  communicator_command_queue.send( TIME_CONSTANT_CHANGED, 1);
-		break;
-	      case ANT_BASELENGTH:
-	      case ANT_SLAVE_DOWN:
-	      case ANT_SLAVE_RIGHT:
-		  communicator_command_queue.send( GNSS_CONFIG_CHANGED, 1);
-		break;
-	      case PITOT_OFFSET:
-	      case PITOT_SPAN:
-	      case QNH_OFFSET:
-		  communicator_command_queue.send( TUNE_PRESSURE_GAUGES, 1);
-		break;
-	      case HORIZON:
-		  communicator_command_queue.send( HORIZON_LOCK_CHANGED, 1);
-		break;
-	      default:
-		break;
-	    }
-	  }
+	if( success) // we need to reset the algorithms because of a significant change
+	  notify_configuration_changes( parameter->change_class);
 
 	return false; // report "nothing read"
       }
@@ -126,6 +102,48 @@ bool EEPROM_config_read_write( const CANpacket & p, float & return_value)
   }
 }
 
+static bool read_CAN_parameter( unsigned index, float & value)
+{
+  return not read_EEPROM_value( CAN_PARAMETERS[index].id, value);
+}
+
+static bool enqueue_config_dump_frame( const CANpacket & packet)
+{
+  return CAN_enqueue( packet, CONFIG_DUMP_FRAME_WAIT);
+}
+
+//! answer to CMD_CONFIG_DUMP_ALL, sent with CAN_Id_Send_Config_Value, see send_config_dump()
+static void dump_all_parameters( void)
+{
+  CANpacket txp ( CAN_Id_Send_Config_Value, 8);
+  (void) send_config_dump( txp, CAN_PARAMETER_COUNT, PARAMETER_OFFSET, CMD_CONFIG_DUMP_ALL,
+			   read_CAN_parameter, enqueue_config_dump_frame);
+}
+
+/*!
+ Answer to CMD_CAN_STATISTICS, sent with CAN_Id_Send_Config_Value:
+ one frame per CAN_statistics_t word: data_h[0] = CMD_CAN_STATISTICS,
+ data_b[2] = word index, data_b[3] = number of words, data_w[1] = counter.
+ */
+static void send_CAN_statistics( void)
+{
+  CAN_statistics_t statistics;
+  CAN_driver.get_statistics( statistics);
+  const uint32_t * word = (const uint32_t *) &statistics;
+  const unsigned words = sizeof( statistics) / sizeof( uint32_t);
+
+  CANpacket txp ( CAN_Id_Send_Config_Value, 8);
+  txp.data_h[0] = CMD_CAN_STATISTICS;
+  txp.data_b[3] = words;
+  for( unsigned index = 0; index < words; ++index)
+    {
+      txp.data_b[2] = index;
+      txp.data_w[1] = word[index];
+      if( not CAN_enqueue( txp, CONFIG_DUMP_FRAME_WAIT))
+	return; // give up, the frontend will detect the missing frames
+    }
+}
+
 #define XTRA_ACC_SCALE 2.39215e-3f
 #define XTRA_GYRO_SCALE 0.000076358f
 #define XTRA_MAG_SCALE 1.22e-4f;
@@ -194,6 +212,9 @@ void CAN_listener_task_runnable (void*)
 {
   TickType_t magnetometer_last_heard = 0;
 
+  // the CAN parameter registry refers to PERSISTENT_DATA for the parameter details
+  ASSERT( CAN_parameter_mismatch( PERSISTENT_DATA, PERSISTENT_DATA_ENTRIES) == CAN_PARAMETER_COUNT);
+
   CAN_distributor_entry my_entry
     { 0x040F, 0x0402, &can_packet_q }; // Listen for "Set System Wide Config Item" on CAN
   subscribe_CAN_messages (my_entry);
@@ -272,6 +293,22 @@ extern Semaphore trigger_flash_fill;
 		communicator_command_queue.send (FINE_TUNE_CALIB, 1);
 #endif
 		break;
+	      case CMD_CONFIG_BATCH_BEGIN:
+		config_batch.begin( xTaskGetTickCount());
+		break;
+
+	      case CMD_CONFIG_BATCH_COMMIT:
+		notify_configuration_changes( config_batch.commit( xTaskGetTickCount(), write_staged_parameter));
+		break;
+
+	      case CMD_CONFIG_DUMP_ALL:
+		dump_all_parameters();
+		break;
+
+	      case CMD_CAN_STATISTICS:
+		send_CAN_statistics();
+		break;
+
 	      case CMD_RESET_SENSOR:
 #if CRASFILE_ON_USER_RESET == 0
 		    user_initiated_reset = true;
@@ -283,8 +320,7 @@ extern Semaphore trigger_flash_fill;
 	      default: // try to interpret the command as "set" or "get" value
 		{
 		  // config parameter range check
-		  uint16_t command = p.data_h[0];
-		  if(( command < PARAMETER_OFFSET) || (command >= ( PARAMETER_OFFSET + PARAMETER_LIST_LENGTH)))
+		  if( find_CAN_parameter( p.data_h[0]) == 0)
 		    break; // ignore invalid parameter ID
 
 		  float value;
@@ -299,7 +335,7 @@ extern Semaphore trigger_flash_fill;
 		      ASSERT(read_successful);
 
 		      CANpacket txp ( CAN_Id_Send_Config_Value, 8);
-		      txp.data_w[0] = p.data_h[0]; // the ID we have received
+		      txp.data_w[0] = p.data_h[0]; // the ID we have received, data_b[2] = data_b[3] = 0
 		      txp.data_f[1] = value;
 		      bool ok = CAN_enqueue (txp, 1);
 
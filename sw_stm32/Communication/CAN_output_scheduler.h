@@ -0,0 +1,165 @@
+/***********************************************************************//**
+ * @file		CAN_output_scheduler.h
+ * @brief		spreads the periodic CAN output over the 100 Hz sub-ticks
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#ifndef CAN_OUTPUT_SCHEDULER_H_
+#define CAN_OUTPUT_SCHEDULER_H_
+
+#include "stdint.h"
+#include "CAN_bus_timing.h"
+
+#define CAN_OUTPUT_SUBTICKS 10 //!< 100 Hz sub-ticks per 10 Hz output cycle
+
+/*!
+ The output frame set of one cycle is captured at once and released slot by slot.
+ A frame class is one CAN ID, or its n-th occurrence if an ID is sent several times per cycle.
+ Each class gets the sub-tick with the least planned load as its phase when it first appears,
+ and a decimation that is raised for the highest IDs while the load passed to adapt() exceeds the budget.
+ No target dependencies: the bus timing can be simulated on a host.
+ */
+template <class packet_t, unsigned CLASSES>
+class CAN_output_scheduler_t
+{
+public:
+  enum { MAX_DECIMATION = 8 };
+
+  CAN_output_scheduler_t( void)
+    : classes( 0)
+  {
+    for( unsigned i = 0; i < CAN_OUTPUT_SUBTICKS; ++i)
+      subtick_bits[i] = 0;
+  }
+
+  //! a new output cycle begins, the producer emits its frame set afterwards
+  void start_cycle( void)
+  {
+    for( unsigned i = 0; i < classes; ++i)
+      frame[i].captured = false;
+  }
+
+  //! @return false if the frame could not be scheduled and has to be sent directly
+  bool capture( const packet_t &packet)
+  {
+    unsigned i = 0;
+    while( ( i < classes) && ( ( frame[i].packet.id != packet.id) || frame[i].captured))
+      ++i;
+
+    if( i == classes) // new frame class
+      {
+	if( classes == CLASSES)
+	  return false;
+
+	unsigned phase = 0;
+	for( unsigned k = 1; k < CAN_OUTPUT_SUBTICKS; ++k)
+	  if( subtick_bits[k] < subtick_bits[phase])
+	    phase = k;
+
+	frame[i].phase = phase;
+	frame[i].decimation = 1;
+	frame[i].countdown = 1;
+	frame[i].bits = CAN_frame_bits( packet.dlc);
+	subtick_bits[phase] += frame[i].bits;
+	++classes;
+      }
+
+    frame[i].packet = packet;
+    frame[i].captured = true;
+    frame[i].pending = true;
+    return true;
+  }
+
+  //! send the frames scheduled up to this sub-tick that are still pending
+  //! @return number of frames sent
+  template <class send_t>
+  unsigned release( unsigned subtick, send_t send)
+  {
+    unsigned sent = 0;
+    for( unsigned i = 0; i < classes; ++i)
+      {
+	if( ( ! frame[i].pending) || ( frame[i].phase > subtick))
+	  continue;
+	frame[i].pending = false;
+	if( --frame[i].countdown != 0)
+	  continue; // decimated
+	frame[i].countdown = frame[i].decimation;
+	send( frame[i].packet);
+	++sent;
+      }
+    return sent;
+  }
+
+  //! one step per call: thin out the highest ID above the budget, restore the lowest below half of it
+  void adapt( unsigned load_percent, unsigned budget_percent)
+  {
+    unsigned selected = classes;
+    if( load_percent > budget_percent)
+      {
+	for( unsigned i = 0; i < classes; ++i)
+	  if( ( frame[i].decimation < MAX_DECIMATION)
+	      && ( ( selected == classes) || ( frame[i].packet.id > frame[selected].packet.id)))
+	    selected = i;
+	if( selected < classes)
+	  frame[selected].decimation *= 2;
+      }
+    else if( load_percent < budget_percent / 2)
+      {
+	for( unsigned i = 0; i < classes; ++i)
+	  if( ( frame[i].decimation > 1)
+	      && ( ( selected == classes) || ( frame[i].packet.id < frame[selected].packet.id)))
+	    selected = i;
+	if( selected < classes)
+	  {
+	    frame[selected].decimation /= 2;
+	    frame[selected].countdown = 1;
+	  }
+      }
+  }
+
+  //! planned bits per sub-tick without decimation
+  uint32_t get_subtick_bits( unsigned subtick) const
+  {
+    return subtick_bits[ subtick];
+  }
+
+  unsigned get_class_count( void) const
+  {
+    return classes;
+  }
+
+private:
+  typedef struct
+  {
+    packet_t packet;
+    uint16_t bits;
+    uint8_t phase;
+    uint8_t decimation;
+    uint8_t countdown;
+    bool captured;	//!< seen in this cycle
+    bool pending;	//!< waiting for its sub-tick
+  } frame_class_t;
+
+  frame_class_t frame[ CLASSES];
+  unsigned classes;
+  uint32_t subtick_bits[ CAN_OUTPUT_SUBTICKS];
+};
+
+#endif /* CAN_OUTPUT_SCHEDULER_H_ */
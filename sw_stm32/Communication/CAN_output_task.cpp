@@ -26,40 +26,92 @@
 #include "CAN_output.h"
 #include "communicator.h"
 #include "system_state.h"
+#include "candriver.h"
+#include "CAN_output_scheduler.h"
 
 COMMON Queue <CANpacket> CAN_pipeline( 5);
+COMMON bool CAN_new_output_cycle;
+COMMON volatile unsigned CAN_output_ticks;
 
 bool CAN_enqueue( const CANpacket &p, unsigned max_delay)
 {
   return CAN_pipeline.send( p, max_delay);
 }
 
+#if SPREAD_CAN_OUTPUT
+
+COMMON static CAN_output_scheduler_t <CANpacket, 32> CAN_output_scheduler;
+
+static bool capture_output_frame( const CANpacket &p)
+{
+  return CAN_output_scheduler.capture( p);
+}
+
+static void send_output_frame( const CANpacket &p)
+{
+  CAN_send( p, 1);
+}
+
+#endif
+
 void CAN_task_runnable( void *)
 {
   suspend();
 
   unsigned decimator_1_second=10;
+#if SPREAD_CAN_OUTPUT
+  unsigned cycle_start = CAN_output_ticks;
+  uint32_t tx_bits = CAN_driver.get_tx_bits();
+#endif
 
   delay(5000); // allow data acquisition setup
 
   while( true)
     {
-      notify_take(); // synchronize with data acquisition
+      notify_take( true); // synchronize with data acquisition
 
-      bool horizon_available = (system_state & HORIZON_NOT_AVAILABLE) == 0;
+      if( CAN_new_output_cycle)
+	{
+	  CAN_new_output_cycle = false;
+#if SPREAD_CAN_OUTPUT
+	  cycle_start = CAN_output_ticks; // read after the flag, already counts this tick
+	  CAN_output_scheduler.release( CAN_OUTPUT_SUBTICKS - 1, send_output_frame); // leftovers of a late cycle
+	  CAN_output_scheduler.start_cycle();
+	  set_CAN_send_hook( capture_output_frame); // collect the frame set instead of a burst
+#endif
+	  bool horizon_available = (system_state & HORIZON_NOT_AVAILABLE) == 0;
 
 #if SUPPORT_D_GNSS_ACCURACY
-      CAN_output( observations, coordinates, state_vector, accuracy, horizon_available);
+	  CAN_output( observations, coordinates, state_vector, accuracy, horizon_available);
 #else
-      CAN_output( observations, coordinates, state_vector, horizon_available);
+	  CAN_output( observations, coordinates, state_vector, horizon_available);
 #endif
-      --decimator_1_second;
-      if( decimator_1_second < 1)
-	{
-	  decimator_1_second=10;
-	  CAN_heartbeat();
+#if SPREAD_CAN_OUTPUT
+	  set_CAN_send_hook( 0); // the heartbeat must never be decimated
+#endif
+	  --decimator_1_second;
+	  if( decimator_1_second < 1)
+	    {
+	      decimator_1_second=10;
+	      CAN_heartbeat();
+
+#if SPREAD_CAN_OUTPUT
+	      uint32_t bits = CAN_driver.get_tx_bits();
+	      CAN_output_scheduler.adapt( ( bits - tx_bits) / ( CAN_BIT_RATE / 100), CAN_TX_LOAD_BUDGET_PERCENT);
+	      tx_bits = bits;
+#endif
+	    }
 	}
 
+#if SPREAD_CAN_OUTPUT
+      { // catch up with sub-ticks we have missed when notifications coalesced
+	unsigned subtick = CAN_output_ticks - cycle_start;
+	CAN_output_scheduler.release(
+	    subtick < CAN_OUTPUT_SUBTICKS ? subtick : CAN_OUTPUT_SUBTICKS - 1,
+	    send_output_frame);
+      }
+#endif
+
       CANpacket p;
       while( CAN_pipeline.receive( p, 0))
 	  CAN_send(p, 1);
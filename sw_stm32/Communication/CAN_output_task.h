@@ -28,9 +28,21 @@
 
 extern RestrictedTask CAN_task;
 
+extern bool CAN_new_output_cycle;
+extern volatile unsigned CAN_output_ticks; //!< 100 Hz ticks of the communicator, notifications may coalesce
+
 //!< helper routine to synchronize the CAN output loop
 inline void trigger_CAN(void)
 {
+  ++CAN_output_ticks;
+  CAN_new_output_cycle = true;
+  CAN_task.notify_give();
+}
+
+//!< 100 Hz tick between two output cycles
+inline void trigger_CAN_subtick(void)
+{
+  ++CAN_output_ticks;
   CAN_task.notify_give();
 }
 
@@ -0,0 +1,115 @@
+/***********************************************************************//**
+ * @file		CAN_parameter_registry.h
+ * @brief		EEPROM parameters accessible via CAN, checked at compile time
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#ifndef CAN_PARAMETER_REGISTRY_H_
+#define CAN_PARAMETER_REGISTRY_H_
+
+#include "persistent_data.h"
+
+#define PARAMETER_OFFSET 0x2000 //!< CAN command = PARAMETER_OFFSET + CAN index
+
+//! algorithm groups that need a reset after a parameter change
+enum
+{
+  CHANGE_NONE		= 0,
+  CHANGE_TIME_CONSTANT 	= 1,
+  CHANGE_GNSS 		= 2,
+  CHANGE_PRESSURE 	= 4,
+  CHANGE_HORIZON 	= 8
+};
+
+typedef struct
+{
+  EEPROM_PARAMETER_ID id;
+  uint8_t change_class;
+} CAN_parameter_t;
+
+//! the position within this list is the CAN index, never reorder, append only
+constexpr CAN_parameter_t CAN_PARAMETERS[] =
+    {
+	{ SENS_TILT_ROLL,	CHANGE_NONE},
+	{ SENS_TILT_PITCH,	CHANGE_NONE},
+	{ SENS_TILT_YAW,	CHANGE_NONE},
+	{ PITOT_OFFSET,		CHANGE_PRESSURE},
+	{ PITOT_SPAN,		CHANGE_PRESSURE},
+	{ QNH_OFFSET,		CHANGE_PRESSURE},
+	{ MAG_AUTO_CALIB,	CHANGE_NONE},
+	{ VARIO_TC,		CHANGE_TIME_CONSTANT},
+	{ VARIO_INT_TC,		CHANGE_TIME_CONSTANT},
+	{ WIND_TC,		CHANGE_TIME_CONSTANT},
+	{ MEAN_WIND_TC,		CHANGE_NONE},
+	{ GNSS_CONFIGURATION,	CHANGE_NONE},
+	{ ANT_BASELENGTH,	CHANGE_GNSS},
+	{ ANT_SLAVE_DOWN,	CHANGE_GNSS},
+	{ ANT_SLAVE_RIGHT,	CHANGE_GNSS},
+	{ VARIO_P_TC,		CHANGE_TIME_CONSTANT},
+	{ HORIZON,		CHANGE_HORIZON}
+    };
+
+constexpr unsigned CAN_PARAMETER_COUNT = sizeof( CAN_PARAMETERS) / sizeof( CAN_parameter_t);
+
+constexpr bool CAN_parameter_ids_valid( void)
+{
+  for( unsigned i = 0; i < CAN_PARAMETER_COUNT; ++i)
+    {
+      if( CAN_PARAMETERS[i].id >= LOWEST_UNUSED_EEPROM_ID)
+	return false;
+      for( unsigned k = i + 1; k < CAN_PARAMETER_COUNT; ++k)
+	if( CAN_PARAMETERS[i].id == CAN_PARAMETERS[k].id)
+	  return false;
+    }
+  return true;
+}
+
+static_assert( CAN_parameter_ids_valid(), "CAN parameter list: invalid or duplicate EEPROM ID");
+static_assert( CAN_PARAMETER_COUNT <= 32, "CAN parameter list: too long for the config batch mask");
+
+/*!
+ Mnemonic, angle flag and default value of a CAN parameter are taken from its
+ PERSISTENT_DATA entry, which is defined in the lib module and can not be checked
+ at compile time. The CAN listener checks at boot that both tables agree.
+ @return CAN index of the first parameter not found exactly once in table, CAN_PARAMETER_COUNT if all agree
+ */
+inline unsigned CAN_parameter_mismatch( const persistent_data_t * table, unsigned entries)
+{
+  for( unsigned index = 0; index < CAN_PARAMETER_COUNT; ++index)
+    {
+      unsigned found = 0;
+      for( unsigned i = 0; i < entries; ++i)
+	if( table[i].id == CAN_PARAMETERS[index].id)
+	  ++found;
+      if( found != 1)
+	return index;
+    }
+  return CAN_PARAMETER_COUNT;
+}
+
+//! @return registry entry for a CAN command or 0
+inline const CAN_parameter_t * find_CAN_parameter( uint16_t command)
+{
+  if(( command < PARAMETER_OFFSET) || (command >= ( PARAMETER_OFFSET + CAN_PARAMETER_COUNT)))
+    return 0;
+  return CAN_PARAMETERS + ( command - PARAMETER_OFFSET);
+}
+
+#endif /* CAN_PARAMETER_REGISTRY_H_ */
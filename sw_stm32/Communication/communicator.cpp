@@ -40,6 +40,12 @@
 #include "EEPROM_data_file_implementation.h"
 #include "communicator.h"
 #include "flexible_log_file_implementation.h"
+#include "log_rate_scheduler.h"
+#include "log_snapshot.h"
+#include "CAN_parameter_registry.h"
+#if LOG_COMPRESSED_SENSOR_DATA
+#include "sensor_data_compressor.h"
+#endif
 
 COMMON D_GNSS_coordinates_t coordinates;
 #if SUPPORT_D_GNSS_ACCURACY
@@ -67,6 +73,37 @@ COMMON GNSS_type GNSS ( coordinates);
 
 COMMON Queue < communicator_command_t> communicator_command_queue(2);
 
+//! change classes reported by notify_configuration_changes(), collected until the next 100 Hz cycle
+COMMON static uint32_t pending_configuration_changes;
+
+void notify_configuration_changes( unsigned changes)
+{
+  __atomic_fetch_or( &pending_configuration_changes, changes, __ATOMIC_RELAXED);
+}
+
+//! organizer command per change class
+static ROM struct
+{
+  unsigned change_class;
+  communicator_command_t command;
+} configuration_change_command[] =
+  {
+      { CHANGE_TIME_CONSTANT,	TIME_CONSTANT_CHANGED},
+      { CHANGE_GNSS,		GNSS_CONFIG_CHANGED},
+      { CHANGE_PRESSURE,	TUNE_PRESSURE_GAUGES},
+      { CHANGE_HORIZON,		HORIZON_LOCK_CHANGED}
+  };
+
+//! log decimation per stream, may be overwritten from the rates file at boot
+COMMON uint16_t log_decimation[ LOG_STREAM_COUNT] =
+  {
+      1,	// BASIC_SENSOR_DATA	100 Hz
+      1,	// MAGNETOMETER_DATA	100 Hz
+      1,	// GNSS_DATA		every GNSS update
+      10,	// D_GNSS_ACC		every 10th D_GNSS_DATA record
+      LOG_STATISTICS_INTERVAL_S * 100 // LOG_STATISTICS
+  };
+
 extern RestrictedTask NMEA_task;
 extern RestrictedTask communicator_task;
 
@@ -190,15 +227,34 @@ communicator_runnable (void*)
   CAN_task.resume ();
 
   unsigned synchronizer_10Hz = 10; 	// re-sampling 100Hz -> 10Hz
-  unsigned D_GNSS_ACC_count = 10;
   unsigned GNSS_watchdog = 0;		// monitor incoming GNSS data rate
   unsigned GNSS_LED_count = 0;		// maintain GNSS LED
   unsigned old_system_state = 0; 	// trigger on system state changes
+#if MEASURE_LOG_APPEND_CYCLES
+  uint32_t max_append_cycles = 0;	// worst case logger append time
+#endif
+  log_rate_scheduler_t log_scheduler( log_decimation);
+  enum { SNAPSHOT_NONE, SNAPSHOT_FILE_HEADER, SNAPSHOT_UPDATE }
+  snapshot_pending = SNAPSHOT_NONE;	// configuration records still to be written
+#if MEASURE_COMMUNICATOR_LOOP_TIME
+  uint32_t max_loop_time = 0;		// usec
+#endif
+#if LOG_INDEX_INTERVAL_S
+  uint32_t next_index_time = 0;		// GNSS time of the next LOG_INDEX record
+#endif
+#if LOG_COMPRESSED_SENSOR_DATA
+  typedef sensor_data_compressor < sizeof(observations) / sizeof(uint32_t)> compressor_t;
+  compressor_t compressor;
+  unsigned compressor_overruns = 0;	// logger overruns seen by the compressor
+#endif
 
   // this is the MAIN data acquisition and processing loop **********************************************
   while (true)
     {
       notify_take (true); // wait for synchronization by IMU @ 100 Hz
+#if MEASURE_COMMUNICATOR_LOOP_TIME
+      uint64_t loop_start = getTime_usec();
+#endif
 
       if (GNSS_new_data_ready) // triggered after 75ms or 100ms, GNSS-dependent
 	{
@@ -251,6 +307,25 @@ communicator_runnable (void*)
 	   }
 	}
 
+      unsigned configuration_changes = __atomic_exchange_n( &pending_configuration_changes, 0u, __ATOMIC_RELAXED);
+      if( configuration_changes)
+	{
+	  bool significant_configuration_change = false;
+	  for( unsigned i = 0; i < sizeof( configuration_change_command) / sizeof( configuration_change_command[0]); ++i)
+	    if( configuration_changes & configuration_change_command[i].change_class)
+	      {
+		communicator_command_t command = configuration_change_command[i].command;
+		signal_logger_event( CAN_COMMAND_RECEIVED | (command << 8));
+		significant_configuration_change |= organizer.on_command( command, coordinates, observations);
+	      }
+
+	  if( significant_configuration_change)
+	    {
+	      report_horizon_avalability ();
+	      write_configuration_data_now.set();
+	    }
+	}
+
       bool significant_configuration_change = organizer.manage_attitude_setup_in_progress( coordinates, observations);
 
       if( significant_configuration_change)
@@ -268,10 +343,17 @@ communicator_runnable (void*)
 	  bool landing_detected_here = organizer.update_at_10Hz ( coordinates, observations);
 
 	  if (landing_detected_here)
+	    {
+	      flex_file.finish(); // index footer, written here as we are the only producer
 	      perform_after_landing_actions.set ();
+	    }
 
 	  trigger_CAN (); // we have new information, deliver it NOW !
 	}
+#if SPREAD_CAN_OUTPUT
+      else
+	trigger_CAN_subtick (); // release the next slice of the CAN frame set
+#endif
 
       // service the GNSS LED ****************************************************************************
       ++GNSS_LED_count;
@@ -322,53 +404,98 @@ communicator_runnable (void*)
       organizer.report_data (state_vector);
 
       // write log file ********************************************************************************
-      if( flex_file.is_open ()) // data logging is active
+      if( flex_file.is_open () && log_file_opened.test_and_reset())
 	{
-	  bool write_configuration = write_configuration_data_now.test_and_reset();
-	  if( write_configuration) // need to write the EEPROM content
-	      {
-	      // write all valid EEPROM content packed as one flexible file record
-		  {
-		    uint32_t file_format_version =
-			flexible_log_file_implementation_t::FLEXIBLE_LOG_FILE_FORMAT_VERSION;
-		    flex_file.append_record ( FILE_FORMAT_VERSION, &file_format_version, 1);
-
-		    // write hardware, firmware id and FLASH SHA256
-#define DESCRIPTION_SIZE_BYTES (32+sizeof( uint32_t)*4+32)
-		    uint8_t description[DESCRIPTION_SIZE_BYTES];
-		    memset( description, 0, 32);
-		    strcpy( (char *)description, GIT_TAG_INFO); // fw string
-		    extern  uint32_t UNIQUE_ID[4];
-		    memcpy( description+32, UNIQUE_ID, sizeof( uint32_t)*4); // hw ID
-		    memcpy( description+32+16, firmware_SHA256_digest, 32); // flash program SHA256 digest
-		    flex_file.append_record ( LARUS_DESCRIPTION, (uint32_t *)description, DESCRIPTION_SIZE_BYTES / sizeof( uint32_t));
-		  }
+	  request_log_snapshot(); // prepared by a low priority task
+	  snapshot_pending = SNAPSHOT_FILE_HEADER;
+	  write_configuration_data_now.test_and_reset(); // part of the header
+
+	  log_scheduler.set_profile( log_decimation); // may have been changed by the rates file
+#if LOG_COMPRESSED_SENSOR_DATA
+	  compressor.restart(); // a new file needs a keyframe
+	  compressor_overruns = flex_file.get_overrun_count();
+#endif
+#if LOG_INDEX_INTERVAL_S
+	  next_index_time = 0;
+#endif
+	}
+
+      if( flex_file.is_open () && write_configuration_data_now.test_and_reset()) // configuration change
+	{
+	  request_log_snapshot(); // a pending snapshot is prepared again with the new configuration
+	  if( snapshot_pending == SNAPSHOT_NONE)
+	    snapshot_pending = SNAPSHOT_UPDATE;
+	}
+
+      if( flex_file.is_open () && ( snapshot_pending != SNAPSHOT_NONE))
+	{
+	  const log_snapshot_t * snapshot = get_log_snapshot();
+	  if( snapshot && ( snapshot_pending == SNAPSHOT_FILE_HEADER))
+	    {
+	      flex_file.append_record ( FILE_FORMAT_VERSION, (uint32_t *)&snapshot->file_format_version, 1);
+	      flex_file.append_record ( LARUS_DESCRIPTION, (uint32_t *)snapshot->description, DESCRIPTION_SIZE_BYTES / sizeof( uint32_t));
+	      flex_file.append_record ( EEPROM_FILE, (uint32_t *)snapshot->flash_data_copy, snapshot->flash_data_size_words);
 
-		  // write all valid EEPROM content packed as one flexible file record
+	      flex_file.append_record (SENSOR_STATUS, &system_state, 1);
+	      old_system_state = system_state;
+	      snapshot_pending = SNAPSHOT_NONE;
+	    }
+	  else if( snapshot) // in the middle of the data, not to be taken for a file header
+	    {
+	      flex_file.append_record ( CONFIGURATION_UPDATE, (uint32_t *)snapshot->flash_data_copy, snapshot->flash_data_size_words);
+	      snapshot_pending = SNAPSHOT_NONE;
+	    }
+	}
+
+      // a new file starts with its configuration, no data before the header
+      if( flex_file.is_open () && ( snapshot_pending != SNAPSHOT_FILE_HEADER))
+	{
+	  if (system_state != old_system_state)
+	    {
+	      flex_file.append_record (SENSOR_STATUS, &system_state, 1);
+	      old_system_state = system_state;
+	    }
+
+	  if( log_scheduler.due( LOG_STREAM_SENSOR))
+	    {
+#if MEASURE_LOG_APPEND_CYCLES
+	      acquire_privileges(); // DWT access
+	      if( not (DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk))
+		{
+		  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+		  DWT->CYCCNT = 0;
+		  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+		}
+	      uint32_t append_cycles = DWT->CYCCNT;
+#endif
+
+#if LOG_COMPRESSED_SENSOR_DATA
+	      {
+		if( flex_file.get_overrun_count() != compressor_overruns) // records lost, decoder needs a keyframe
 		  {
-#define FLASH_DATA_COPY_SIZE_WORDS 128
-		    uint32_t flash_data_copy[FLASH_DATA_COPY_SIZE_WORDS];
-		    EEPROM_file_system <LOWEST_UNUSED_EEPROM_ID> flash_data_file(
-			(EEPROM_file_system_node *)flash_data_copy, (EEPROM_file_system_node *)flash_data_copy+FLASH_DATA_COPY_SIZE_WORDS);
-		    flash_data_file.import_all_data( permanent_data_file, false);
-		    flex_file.append_record ( EEPROM_FILE, flash_data_copy, flash_data_file.get_size()/sizeof(uint32_t));
+		    compressor_overruns = flex_file.get_overrun_count();
+		    compressor.restart();
 		  }
-
-		  flex_file.append_record (SENSOR_STATUS, &system_state, 1);
-		  old_system_state = system_state;
+		uint32_t packed[ compressor_t::MAX_SIZE_WORDS];
+		unsigned size = compressor.encode( (uint32_t*) &observations, packed);
+		flex_file.append_record ( COMPRESSED_SENSOR_DATA, packed, size);
 	      }
-	  else
-	    {
-	      if (system_state != old_system_state)
+#else
+	      flex_file.append_record ( BASIC_SENSOR_DATA, (uint32_t*) &observations, sizeof(observations) / sizeof(uint32_t));
+#endif
+
+#if MEASURE_LOG_APPEND_CYCLES
+	      append_cycles = DWT->CYCCNT - append_cycles;
+	      drop_privileges();
+	      if( append_cycles > max_append_cycles)
 		{
-		  flex_file.append_record (SENSOR_STATUS, &system_state, 1);
-		  old_system_state = system_state;
+		  max_append_cycles = append_cycles;
+		  signal_logger_event( DEBUGGER_DATA | (append_cycles << 8));
 		}
+#endif
 	    }
 
-	  flex_file.append_record ( BASIC_SENSOR_DATA, (uint32_t*) &observations, sizeof(observations) / sizeof(uint32_t));
-
-	  if (system_state & EXTERNAL_MAGNETOMETER_AVAILABLE)
+	  if( log_scheduler.due( LOG_STREAM_MAGNETOMETER) && (system_state & EXTERNAL_MAGNETOMETER_AVAILABLE))
 	    {
 	      flex_file.append_record (
 		  MAGNETOMETER_DATA, (uint32_t*) &external_magnetometer,
@@ -379,32 +506,54 @@ communicator_runnable (void*)
 	    {
 	      GNSS_new_data_ready = false;
 
-	      switch (coordinates.sat_fix_type)
+#if LOG_INDEX_INTERVAL_S
+	      if( coordinates.sat_fix_type != SAT_FIX_NONE) // GNSS time valid
 		{
-		case SAT_FIX:
-		default:
-		  flex_file.append_record (
-		      GNSS_DATA, (uint32_t*) &coordinates,  sizeof(GNSS_coordinates_t) / sizeof(uint32_t));
-		  break;
-		case SAT_FIX | SAT_HEADING:
-		  flex_file.append_record (
-		      D_GNSS_DATA, (uint32_t*) &coordinates, sizeof(D_GNSS_coordinates_t) / sizeof(uint32_t));
-
-#if SUPPORT_D_GNSS_ACCURACY
-		  --D_GNSS_ACC_count;
-		  if( D_GNSS_ACC_count == 0)
+		  uint32_t time = make_log_index_time( coordinates.day, coordinates.hour, coordinates.minute, coordinates.second);
+		  if( time >= next_index_time)
 		    {
-		      D_GNSS_ACC_count = 10;
-		      flex_file.append_record (
-			  D_GNSS_ACC, (uint32_t*) &accuracy, sizeof(D_GNSS_accuracy_t) / sizeof(uint32_t));
+		      flex_file.append_index( time); // points to the following GNSS record
+		      next_index_time = time - time % LOG_INDEX_INTERVAL_S + LOG_INDEX_INTERVAL_S;
 		    }
-#endif
-		  break;
-		case SAT_FIX_NONE: // need to log the GNSS status like number of visible satellites etc
-		  flex_file.append_record (
-		      GNSS_DATA, (uint32_t*) &coordinates,   sizeof(GNSS_coordinates_t) / sizeof(uint32_t));
-		  break;
 		}
+#endif
+
+	      if( log_scheduler.due( LOG_STREAM_GNSS))
+		switch (coordinates.sat_fix_type)
+		  {
+		  case SAT_FIX:
+		  default:
+		    flex_file.append_record (
+			GNSS_DATA, (uint32_t*) &coordinates,  sizeof(GNSS_coordinates_t) / sizeof(uint32_t));
+		    break;
+		  case SAT_FIX | SAT_HEADING:
+		    flex_file.append_record (
+			D_GNSS_DATA, (uint32_t*) &coordinates, sizeof(D_GNSS_coordinates_t) / sizeof(uint32_t));
+
+#if SUPPORT_D_GNSS_ACCURACY
+		    if( log_scheduler.due( LOG_STREAM_D_GNSS_ACC))
+		      {
+			flex_file.append_record (
+			    D_GNSS_ACC, (uint32_t*) &accuracy, sizeof(D_GNSS_accuracy_t) / sizeof(uint32_t));
+		      }
+#endif
+		    break;
+		  case SAT_FIX_NONE: // need to log the GNSS status like number of visible satellites etc
+		    flex_file.append_record (
+			GNSS_DATA, (uint32_t*) &coordinates,   sizeof(GNSS_coordinates_t) / sizeof(uint32_t));
+		    break;
+		  }
+	    }
+
+	  if( log_scheduler.due( LOG_STREAM_STATISTICS))
+	    {
+	      log_statistics_t statistics;
+	      flex_file.get_statistics( statistics);
+	      flex_file.append_record ( LOG_STATISTICS, (uint32_t*) &statistics, sizeof(statistics) / sizeof(uint32_t));
+
+	      CAN_statistics_t CAN_statistics;
+	      CAN_driver.get_statistics( CAN_statistics);
+	      flex_file.append_record ( CAN_STATISTICS, (uint32_t*) &CAN_statistics, sizeof(CAN_statistics) / sizeof(uint32_t));
 	    }
 
 	  { // process event if any
@@ -414,6 +563,15 @@ communicator_runnable (void*)
 	  }
 
 	} // log file write loop ****************************************************************************
+
+#if MEASURE_COMMUNICATOR_LOOP_TIME
+      uint32_t loop_time = getTime_usec() - loop_start;
+      if( loop_time > max_loop_time)
+	{
+	  max_loop_time = loop_time;
+	  signal_logger_event( DEBUGGER_DATA | (loop_time << 8));
+	}
+#endif
     }     // IMU 100Hz loop
 }         // task runnable
 
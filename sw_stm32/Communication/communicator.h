@@ -27,6 +27,7 @@
 #include "data_structures.h"
 #include "reminder_flag.h"
 #include "communicator_command.h"
+#include "log_rate_scheduler.h"
 
 extern D_GNSS_coordinates_t coordinates;
 #if SUPPORT_D_GNSS_ACCURACY
@@ -38,5 +39,9 @@ extern state_vector_t state_vector;
 
 extern RestrictedTask communicator_task;
 extern Queue < communicator_command_t> communicator_command_queue;
+extern uint16_t log_decimation[ LOG_STREAM_COUNT];
+
+//! report parameter change classes ( CHANGE_xxx), handled together within the next 100 Hz cycle
+void notify_configuration_changes( unsigned changes);
 
 #endif /* COMMUNICATOR_H_ */
@@ -0,0 +1,90 @@
+/***********************************************************************//**
+ * @file		config_batch.h
+ * @brief		configuration batch: staged CAN parameter writes, one notification
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#ifndef CONFIG_BATCH_H_
+#define CONFIG_BATCH_H_
+
+#include "stdint.h"
+
+/*!
+ Values of an open configuration batch, one entry per CAN parameter index, the latest value wins.
+ A batch not committed within the timeout is discarded, the frontend has given up.
+ This file has no target dependencies and can be used by host tools.
+ */
+template <unsigned COUNT> class config_batch_t
+{
+  static_assert( COUNT <= 32, "config batch: too many parameters for the staged mask");
+public:
+  //! write one value, @return change classes to be notified, 0 if the write failed
+  typedef unsigned ( *writer_t)( unsigned index, float value);
+
+  config_batch_t( uint32_t _timeout)
+    : open( false), staged( 0), opened_at( 0), timeout( _timeout)
+  {}
+
+  void begin( uint32_t now)
+  {
+    open = true;
+    staged = 0;
+    opened_at = now;
+  }
+
+  bool is_open( uint32_t now)
+  {
+    if( open && ( now - opened_at > timeout))
+      open = false;
+    return open;
+  }
+
+  void stage( unsigned index, float value)
+  {
+    if( index >= COUNT)
+      return;
+    staged |= 1u << index;
+    value_list[index] = value;
+  }
+
+  //! write all staged values in index order and close the batch
+  //! @return change classes of all successful writes, to be notified at once
+  unsigned commit( uint32_t now, writer_t write)
+  {
+    if( not is_open( now))
+      return 0;
+    open = false;
+
+    unsigned changes = 0;
+    for( unsigned index = 0; index < COUNT; ++index)
+      if( staged & ( 1u << index))
+	changes |= write( index, value_list[index]);
+    return changes;
+  }
+
+private:
+  bool open;
+  uint32_t staged; 	//!< bit n: parameter index n staged
+  uint32_t opened_at;
+  uint32_t timeout;
+  float value_list[ COUNT];
+};
+
+#endif /* CONFIG_BATCH_H_ */
@@ -0,0 +1,75 @@
+/***********************************************************************//**
+ * @file		config_dump.h
+ * @brief		frames answering a "dump all configuration parameters" request
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#ifndef CONFIG_DUMP_H_
+#define CONFIG_DUMP_H_
+
+#include "stdint.h"
+
+#define CONFIG_DUMP_FLAG	0x80   //!< data_b[3] of all configuration dump frames
+
+/*!
+ Send all parameters in the layout of a single "get" answer:
+ one frame per parameter: data_h[0] = parameter command, data_b[2] = sequence number,
+ data_b[3] = CONFIG_DUMP_FLAG, data_f[1] = value,
+ end frame: data_h[0] = dump command, data_b[2] = sequence number,
+ data_b[3] = CONFIG_DUMP_FLAG | number of parameter frames.
+ A single "get" answer has data_b[2] = data_b[3] = 0, so the frames can not be mistaken for each other.
+ Parameters that can not be read are skipped, the sequence number reveals lost frames.
+ This file has no target dependencies and can be used by host tools.
+ @param txp frame with CAN ID and DLC set
+ @param read parameter value by index, false if not available
+ @param send false: give up, the frontend will detect the missing end frame
+ @return true if the end frame has been sent
+ */
+template <class packet_t>
+bool send_config_dump( packet_t & txp, unsigned count, uint16_t first_command, uint16_t dump_command,
+		       bool ( *read)( unsigned index, float & value),
+		       bool ( *send)( const packet_t & packet))
+{
+  uint8_t sequence = 0;
+  uint8_t sent = 0;
+
+  for( unsigned index = 0; index < count; ++index)
+    {
+      float value;
+      if( not read( index, value))
+	continue;
+
+      txp.data_h[0] = first_command + index;
+      txp.data_b[2] = sequence++;
+      txp.data_b[3] = CONFIG_DUMP_FLAG;
+      txp.data_f[1] = value;
+      if( not send( txp))
+	return false;
+      ++sent;
+    }
+
+  txp.data_h[0] = dump_command;
+  txp.data_b[2] = sequence;
+  txp.data_b[3] = CONFIG_DUMP_FLAG | sent;
+  txp.data_f[1] = 0.0f;
+  return send( txp);
+}
+
+#endif /* CONFIG_DUMP_H_ */
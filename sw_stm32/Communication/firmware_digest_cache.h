@@ -0,0 +1,44 @@
+/***********************************************************************//**
+ * @file		firmware_digest_cache.h
+ * @brief		firmware SHA256 digest cached in the EEPROM file system
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#ifndef FIRMWARE_DIGEST_CACHE_H_
+#define FIRMWARE_DIGEST_CACHE_H_
+
+#include "stdint.h"
+
+//! EEPROM blob carrying the digest of the flash program it has been made from
+//! This file has no target dependencies and can be used by host tools.
+typedef struct
+{
+  uint32_t image_crc;	//!< STM32 hardware CRC of the flash program
+  uint32_t image_size;	//!< bytes
+  uint8_t digest[32];
+} firmware_digest_record_t;
+
+//! the cached digest is used only if it has been made from exactly this program
+inline bool firmware_digest_record_valid( const firmware_digest_record_t &record, uint32_t image_crc, uint32_t image_size)
+{
+  return ( record.image_crc == image_crc) && ( record.image_size == image_size);
+}
+
+#endif /* FIRMWARE_DIGEST_CACHE_H_ */
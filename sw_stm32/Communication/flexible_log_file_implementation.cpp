@@ -5,16 +5,46 @@
 #include "common.h"
 #include "system_configuration.h"
 #include "signal_flight_event.h"
+#include "string.h"
+#include "diskio.h"
+#include "log_file_reservation.h"
+
+extern uint64_t getTime_usec(void);
 
 bool flexible_log_file_implementation_t::open (char *file_name)
 {
   FRESULT fresult;
+#if LOG_FILE_PREALLOCATION_MB
+  (void) record_log_file_reservation( (const TCHAR*)file_name); // before the chain exists
+#endif
   fresult = f_open (&out_file, (const TCHAR*)file_name, FA_CREATE_ALWAYS | FA_WRITE);
   if( fresult == FR_OK)
     {
+#if LOG_FILE_PREALLOCATION_MB
+      // reserve a contiguous cluster chain now to avoid FAT updates in flight
+      FSIZE_t size = (FSIZE_t)LOG_FILE_PREALLOCATION_MB * 1024 * 1024;
+      reserved_bytes = 0;
+      if( FR_OK == reserve_log_file( &out_file, size, cluster_map))
+	{
+	  reserved_bytes = size;
+
+#if LOG_RAW_SD_STREAMING
+	  FATFS * fs = out_file.obj.fs;
+	  if( (ring.get_slot_size_words() * sizeof( uint32_t)) % fs->ssize == 0)
+	    {
+	      stream_sector = fs->database + ( out_file.obj.sclust - 2) * fs->csize;
+	      stream_sector_end = stream_sector + size / fs->ssize;
+	      streamed_bytes = 0;
+	      streaming = true;
+	    }
+#endif
+	}
+#endif
+      ring.reset();
+      index.reset();
+      memset( &statistics, 0, sizeof( statistics));
+      publish_statistics();
       file_is_open = true;
-      write_pointer = buffer;
-      status = FILLING_LOW;
       return true;
     }
   return false;
@@ -22,144 +52,196 @@ bool flexible_log_file_implementation_t::open (char *file_name)
 
 bool flexible_log_file_implementation_t::close( void)
 {
-  file_is_open = false;
+  file_is_open = false; // the footer, if any, has been written by the producer
+
+  // write all complete slots, then the partially filled one
+  flush_buffer();
+
+  if( streaming)
+    stop_streaming(); // the remainder goes through FatFs
+
   UINT writtenBytes = 0;
-  if( status & FILLING_LOW)
-    f_write( &out_file, (const char *)flexible_log_file_t::buffer, (flexible_log_file_t::write_pointer - flexible_log_file_t::buffer) * sizeof( uint32_t), &writtenBytes);
-  else
-    f_write( &out_file, (const char *)second_part, (flexible_log_file_t::write_pointer - second_part) * sizeof( uint32_t), &writtenBytes);
+  f_write( &out_file, (const char *)ring.get_open_slot(), ring.get_open_words() * sizeof( uint32_t), &writtenBytes);
 
-  f_close ( &out_file);
+  // release the unused part of the pre-allocated area
+  close_log_file( &out_file);
 
-  status = 0;
+  ring.reset();
   return true;
 }
 
 bool flexible_log_file_implementation_t::sync_file (void)
 {
   FRESULT fresult;
+  uint64_t time = getTime_usec();
   HAL_GPIO_WritePin (LED_STATUS1_GPIO_Port, LED_STATUS2_Pin, GPIO_PIN_SET);
+  if( streaming)
+    {
+      // FatFs does not know about the raw sectors: let the directory entry cover them now
+      UINT written_bytes;
+      out_file.obj.objsize = streamed_bytes;
+      f_write( &out_file, 0, 0, &written_bytes); // marks the file as modified
+    }
   fresult = f_sync (&out_file);
   HAL_GPIO_WritePin (LED_STATUS1_GPIO_Port, LED_STATUS2_Pin, GPIO_PIN_RESET);
+
+  uint32_t usec = getTime_usec() - time;
+  statistics.sync_latency.add( usec);
+  if( usec > statistics.max_sync_usec)
+    statistics.max_sync_usec = usec;
+  publish_statistics();
+
   return (fresult == FR_OK);
 }
 
-bool flexible_log_file_implementation_t::flush_buffer( void)
+void flexible_log_file_implementation_t::append_index( uint32_t time)
 {
-  UINT written_bytes = 0;
-  FRESULT fresult;
+  if( not file_is_open)
+    return;
+
+  log_index_entry_t entry;
+  entry.time = time;
+  // an overrun drops records now, not after the offset has been taken
+  if( not ring.make_room( sizeof( entry) / sizeof( uint32_t) + LOG_RECORD_OVERHEAD_WORDS))
+    return;
+  entry.offset = get_file_position();
+  index.add( entry.time, entry.offset);
+  append_record( LOG_INDEX, (uint32_t *)&entry, sizeof( entry) / sizeof( uint32_t));
+}
 
-#if MEASURE_WRITE_TIME
-  uint64_t time;
-  extern uint64_t getTime_usec(void);
-  #endif
+//!< index table as the last record, terminated by count and magic to be found from the file end
+void flexible_log_file_implementation_t::append_index_footer( void)
+{
+  uint32_t footer[ LOG_INDEX_FOOTER_ENTRIES * 2 + 2];
+  unsigned count = index.get_count();
+  memcpy( footer, index.get_entries(), count * sizeof( log_index_entry_t));
+  footer[ count * 2] = count;
+  footer[ count * 2 + 1] = LOG_INDEX_FOOTER_MAGIC;
+  append_record( LOG_INDEX_FOOTER, footer, count * 2 + 2);
+}
 
-  unsigned size_bytes = (second_part - buffer) * sizeof( uint32_t);
+//!< write one slot as a single multi-block transfer into the reserved sectors
+bool flexible_log_file_implementation_t::stream_slot( uint32_t * slot)
+{
+  FATFS * fs = out_file.obj.fs;
+  UINT size_bytes = ring.get_slot_size_words() * sizeof( uint32_t);
+  UINT sectors = size_bytes / fs->ssize;
 
-  if( status & WRITING_LOW)
+  if( stream_sector + sectors > stream_sector_end)
     {
-      ASSERT( not( status & FILLING_LOW));
+      stop_streaming(); // reserved area exhausted
+      return false;
+    }
 
-      HAL_GPIO_WritePin (LED_STATUS1_GPIO_Port, LED_STATUS2_Pin, GPIO_PIN_SET);
+  HAL_GPIO_WritePin (LED_STATUS1_GPIO_Port, LED_STATUS2_Pin, GPIO_PIN_SET);
+  DRESULT result = disk_write( fs->drv, (const BYTE *)slot, stream_sector, sectors);
+  HAL_GPIO_WritePin (LED_STATUS1_GPIO_Port, LED_STATUS2_Pin, GPIO_PIN_RESET);
 
-#if MEASURE_WRITE_TIME
-      time = getTime_usec();
-#endif
+  if( result != RES_OK)
+    {
+      block_input();
+      return false;
+    }
 
-      fresult = f_write( &out_file, (const char *)buffer, size_bytes, &written_bytes);
+  stream_sector += sectors;
+  streamed_bytes += size_bytes;
+  return true;
+}
 
-#if MEASURE_WRITE_TIME
-      time = getTime_usec() - time;
-      signal_logger_event( DEBUGGER_DATA | time);
-#endif
-      HAL_GPIO_WritePin (LED_STATUS1_GPIO_Port, LED_STATUS2_Pin, GPIO_PIN_RESET);
+//!< continue with regular FatFs writes behind the streamed data
+void flexible_log_file_implementation_t::stop_streaming( void)
+{
+  streaming = false;
+  out_file.obj.objsize = streamed_bytes; // f_lseek in fast seek mode stops at the file size
+  f_lseek( &out_file, streamed_bytes);
+}
 
-#if 0 // debug version
-      ASSERT(( fresult == FR_OK) && (written_bytes == size_bytes));
-#else
-      if( not (( fresult == FR_OK) && (written_bytes == size_bytes)))
-	block_input();
-#endif
+//!< write all completed slots, runs in the uSD task context
+bool flexible_log_file_implementation_t::flush_buffer( void)
+{
+  UINT written_bytes;
+  FRESULT fresult;
+  unsigned size_bytes = ring.get_slot_size_words() * sizeof( uint32_t);
 
-#if ANALYZE_WRITE_PERFORMANCE // using debugger
-      if( (write_pointer - second_part) > used_size)
+  while( uint32_t * slot = ring.get_completed_slot())
+    {
+      unsigned pending = ring.get_pending_slots();
+      if( pending > statistics.peak_pending_slots)
+	statistics.peak_pending_slots = pending;
+      written_bytes = 0;
+      uint64_t time = getTime_usec();
+
+      if( streaming)
 	{
-	  used_size = write_pointer - second_part;
-	  signal_logger_event( DEBUGGER_DATA | (used_size << 8));
+	  if( stream_slot( slot))
+	    {
+	      record_write_time( getTime_usec() - time);
+	      ring.release_slot();
+	      continue;
+	    }
+	  if( streaming) // write error, else: reserved area exhausted
+	    return false;
 	}
 
-#endif
-    }
-  else if( ( status & WRITING_HIGH))
-    {
-      ASSERT( not( status & FILLING_HIGH));
+      // leaving the pre-allocated area: let FatFs extend the cluster chain from now on
+      if( out_file.cltbl && ( f_tell( &out_file) + size_bytes > reserved_bytes))
+	out_file.cltbl = 0;
 
       HAL_GPIO_WritePin (LED_STATUS1_GPIO_Port, LED_STATUS2_Pin, GPIO_PIN_SET);
-      fresult = f_write( &out_file, (const char *)second_part, size_bytes, &written_bytes);
+      fresult = f_write( &out_file, (const char *)slot, size_bytes, &written_bytes);
       HAL_GPIO_WritePin (LED_STATUS1_GPIO_Port, LED_STATUS2_Pin, GPIO_PIN_RESET);
 
-#if 0 // debug version
-      ASSERT(( fresult == FR_OK) && (written_bytes == size_bytes));
-#else
       if( not (( fresult == FR_OK) && (written_bytes == size_bytes)))
-	block_input();
-#endif
-
-#if ANALYZE_WRITE_PERFORMANCE
-      if( (write_pointer - buffer) > used_size)
 	{
-	  used_size = write_pointer - buffer;
-	  signal_logger_event( DEBUGGER_DATA | (used_size << 8));
+	  block_input();
+	  return false;
 	}
-#endif
-    }
-  else
-    {
-      status &= ~(WRITING_LOW | WRITING_HIGH);
+
+      record_write_time( getTime_usec() - time);
+      ring.release_slot();
     }
 
-  status &= ~(WRITING_LOW | WRITING_HIGH);
+  return true;
+}
+
+void flexible_log_file_implementation_t::record_write_time( uint32_t usec)
+{
+  statistics.write_latency.add( usec);
+  if( usec > statistics.max_write_usec)
+    statistics.max_write_usec = usec;
+  ++statistics.slots_written;
+  publish_statistics();
+}
+
+//!< make the counters visible to other tasks, runs in the uSD task context
+void flexible_log_file_implementation_t::publish_statistics( void)
+{
+  published_statistics.publish( statistics);
+}
 
-  return ( size_bytes == written_bytes);
+void flexible_log_file_implementation_t::get_statistics( log_statistics_t & target) const
+{
+  published_statistics.read( target);
+  target.overruns = ring.get_overrun_count();
 }
 
 bool flexible_log_file_implementation_t::write_block (uint32_t *p_data,
 						 uint32_t size_words)
 {
-  bool need_to_signal = false;
-
-  while (size_words--)
+  while (size_words)
     {
+      unsigned max_chunk = ring.get_slot_size_words() - 1;
+      unsigned chunk = size_words > max_chunk ? max_chunk : size_words;
+      log_span_t span = reserve( chunk);
 
-      *write_pointer++ = *p_data++;
-
-      if (write_pointer >= buffer_end)
-	{
-	  ASSERT(not (status & WRITING_LOW))
-
-	  write_pointer = buffer;
+      memcpy( span.first, p_data, span.first_words * sizeof( uint32_t));
+      if( span.second_words)
+	memcpy( span.second, p_data + span.first_words, span.second_words * sizeof( uint32_t));
 
-	  status &= ~FILLING_HIGH;
-	  status |= FILLING_LOW;
-	  status |= WRITING_HIGH;
-
-	  need_to_signal = true;
-	}
-      else if (write_pointer == second_part)
-	{
-	  ASSERT(not (status & WRITING_HIGH));
-
-	  status &= ~FILLING_LOW;
-	  status |= FILLING_HIGH;
-	  status |= WRITING_LOW;
-
-	  need_to_signal = true;
-
-	}
+      commit( chunk);
+      p_data += chunk;
+      size_words -= chunk;
     }
 
-  if (need_to_signal)
-    signal ();
-
   return true;
 }
@@ -5,18 +5,39 @@
 #include "fatfs.h"
 #include "flexible_log_file.h"
 #include "FreeRTOS_wrapper.h"
+#include "system_configuration.h"
+#include "log_file_index.h"
+#include "log_statistics.h"
+#include "log_slot_ring.h"
+#include "published_copy.h"
+#include "my_assert.h"
+
+// record types not yet part of the flexible_file_format.h list
+#define COMPRESSED_SENSOR_DATA	((flexible_log_file_record_type)0x40)
+#define LOG_INDEX		((flexible_log_file_record_type)0x41)
+#define LOG_INDEX_FOOTER	((flexible_log_file_record_type)0x42)
+#define LOG_STATISTICS		((flexible_log_file_record_type)0x43)
+#define CAN_STATISTICS		((flexible_log_file_record_type)0x44)
+#define CONFIGURATION_UPDATE	((flexible_log_file_record_type)0x45) //!< EEPROM_FILE content after a change in flight
 
 typedef void ( *FPTR)( void); // declare void -> void function pointer
 
+//! upper bound of the framing flexible_log_file_t adds to the payload of a record
+//! checked against the actual framing by append_record()
+#define LOG_RECORD_OVERHEAD_WORDS 4
+
+//! log file writer using a single-producer / single-consumer ring of slots
+//! producer: communicator task ( write_block), consumer: uSD task ( flush_buffer)
 class flexible_log_file_implementation_t : public flexible_log_file_t
 {
 public:
 
-  flexible_log_file_implementation_t ( uint32_t * buf, unsigned size_words, FPTR _signal)
+  flexible_log_file_implementation_t ( uint32_t * buf, unsigned size_words, FPTR _signal, unsigned _slots = LOG_BUFFER_SLOTS)
   : flexible_log_file_t( buf, size_words),
+    reserved_bytes( 0),
+    streaming( false),
     file_is_open( false),
-    status( FILLING_LOW),
-    second_part ( buffer + size_words / 2),
+    ring( buf, size_words, _slots),
     signal( _signal)
   {
   }
@@ -36,8 +57,15 @@ public:
     if( not file_is_open)
       return true; // silently give up
 
+    if( not ring.make_room( data_size_words + LOG_RECORD_OVERHEAD_WORDS))
+      return false; // lost, the uSD card is too slow
+    uint32_t position = ring.get_position();
+
     // delegate to base class
-    return flexible_log_file_t::append_record(type, data, data_size_words);
+    bool result = flexible_log_file_t::append_record(type, data, data_size_words);
+
+    ASSERT( ring.get_position() - position <= data_size_words + LOG_RECORD_OVERHEAD_WORDS);
+    return result;
   }
 
   bool open( char * file_name) override;
@@ -49,26 +77,92 @@ public:
     file_is_open = false;
   }
 
+  //! producer side end of the file: index footer as the last record, then no more input
+  void finish( void)
+  {
+    if( file_is_open)
+      append_index_footer();
+    block_input();
+  }
+
   bool write_block( uint32_t * begin, uint32_t size_words);
 
+  //! reserve size_words ( < one slot) at the write position for in-place serialization
+  log_span_t reserve( unsigned size_words)
+  {
+    ASSERT( size_words < ring.get_slot_size_words());
+    log_span_t span = ring.reserve( size_words);
+    ASSERT( span.first); // only within a record accepted by make_room()
+    return span;
+  }
+
+  //! publish size_words previously obtained from reserve()
+  void commit( unsigned size_words)
+  {
+    if( ring.commit( size_words))
+      signal();
+  }
+
+  //! number of slots that had to be dropped because the uSD card was too slow
+  unsigned get_overrun_count( void) const
+  {
+    return ring.get_overrun_count();
+  }
+
+  //! number of completed slots waiting to be written to the uSD card
+  unsigned get_pending_slots( void) const
+  {
+    return ring.get_pending_slots();
+  }
+
+  unsigned get_slot_count( void) const
+  {
+    return ring.get_slot_count();
+  }
+
+  unsigned get_slot_size_words( void) const
+  {
+    return ring.get_slot_size_words();
+  }
+
+  //! number of slots written to the uSD card since the file has been opened
+  unsigned get_flushed_slots( void) const
+  {
+    return ring.get_flushed_slots();
+  }
+
+  //! file offset in bytes at which the next record will start
+  uint32_t get_file_position( void) const
+  {
+    return ring.get_position() * sizeof( uint32_t);
+  }
+
+  //! copy of the uSD performance counters, callable from any task
+  void get_statistics( log_statistics_t & target) const;
+
+  //! write a LOG_INDEX record and remember it for the footer written by finish()
+  void append_index( uint32_t time);
+
 private:
-  enum {
-    FILLING_LOW=1,
-    FILLING_HIGH=2,
-    WRITING_LOW=4,
-    WRITING_HIGH=8
-  };
-
-  void wrap_around( void);
+  bool stream_slot( uint32_t * slot);
+  void stop_streaming( void);
+  void append_index_footer( void);
+  void record_write_time( uint32_t usec);
+  void publish_statistics( void);
+
   FIL out_file;
+  DWORD cluster_map[4];	//!< fast seek table for the contiguous pre-allocated file
+  FSIZE_t reserved_bytes;	//!< size of the pre-allocated cluster chain, 0 = none
+  bool streaming;	//!< raw sector writes into the pre-allocated area
+  DWORD stream_sector;	//!< next sector to be written while streaming
+  DWORD stream_sector_end;
+  FSIZE_t streamed_bytes;
   bool file_is_open;
-  uint32_t status;
-  uint32_t *second_part;
+  log_slot_ring_t ring;	//!< producer: communicator task, consumer: uSD task
+  log_index_table_t < LOG_INDEX_FOOTER_ENTRIES> index;
+  log_statistics_t statistics;	//!< written by the consumer only
+  published_copy_t < log_statistics_t> published_statistics; //!< for get_statistics()
   FPTR signal;
-#if ANALYZE_WRITE_PERFORMANCE
-  int used_size;
-#endif
-
 };
 
 #endif
@@ -0,0 +1,123 @@
+/***********************************************************************//**
+ * @file		log_file_index.h
+ * @brief		time -> file offset index for the flexible log file
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#ifndef LOG_FILE_INDEX_H_
+#define LOG_FILE_INDEX_H_
+
+#include "stdint.h"
+
+/*
+ LOG_INDEX record:		one log_index_entry_t, offset = position of this record
+ LOG_INDEX_FOOTER record:	log_index_entry_t [count], count, LOG_INDEX_FOOTER_MAGIC
+ The footer is the last record of a properly closed file.
+ Time key: seconds since the start of the GNSS month, see make_log_index_time().
+ This file has no target dependencies and can be used by host tools.
+ */
+
+enum { LOG_INDEX_FOOTER_MAGIC = 0x58444e49}; // "INDX"
+
+typedef struct
+{
+  uint32_t time;	//!< GNSS time key
+  uint32_t offset;	//!< byte offset of a record start within the file
+} log_index_entry_t;
+
+inline uint32_t make_log_index_time( unsigned day, unsigned hour, unsigned minute, unsigned second)
+{
+  return (( day * 24 + hour) * 60 + minute) * 60 + second;
+}
+
+//! fixed size index, halves its resolution when full
+template <unsigned SIZE> class log_index_table_t
+{
+public:
+  log_index_table_t( void)
+  {
+    reset();
+  }
+
+  void reset( void)
+  {
+    count = 0;
+    stride = 1;
+    skip = 0;
+  }
+
+  void add( uint32_t time, uint32_t offset)
+  {
+    if( skip)
+      {
+	--skip;
+	return;
+      }
+    if( count == SIZE) // keep every second entry
+      {
+	for( unsigned i = 0; i < SIZE / 2; ++i)
+	  entry[i] = entry[2 * i];
+	count = SIZE / 2;
+	stride *= 2;
+      }
+    entry[count].time = time;
+    entry[count].offset = offset;
+    ++count;
+    skip = stride - 1;
+  }
+
+  const log_index_entry_t * get_entries( void) const
+  {
+    return entry;
+  }
+
+  unsigned get_count( void) const
+  {
+    return count;
+  }
+
+private:
+  log_index_entry_t entry[ SIZE];
+  unsigned count;
+  unsigned stride;	//!< present decimation
+  unsigned skip;	//!< calls to be ignored until the next entry is taken
+};
+
+//! binary search
+//! @return last entry with entry.time <= time, or 0 if time is before the first entry
+inline const log_index_entry_t * find_log_index_entry(
+    const log_index_entry_t * entries, unsigned count, uint32_t time)
+{
+  if( ( count == 0) || ( time < entries[0].time))
+    return 0;
+
+  unsigned low = 0, high = count; // invariant: entries[low].time <= time
+  while( high - low > 1)
+    {
+      unsigned middle = ( low + high) / 2;
+      if( entries[middle].time <= time)
+	low = middle;
+      else
+	high = middle;
+    }
+  return entries + low;
+}
+
+#endif /* LOG_FILE_INDEX_H_ */
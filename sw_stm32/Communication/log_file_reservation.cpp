@@ -0,0 +1,111 @@
+/***********************************************************************//**
+ * @file		log_file_reservation.cpp
+ * @brief		contiguous log file pre-allocation, released at close or at the next boot
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#include "log_file_reservation.h"
+#include "string.h"
+
+FRESULT record_log_file_reservation( const TCHAR * file_name)
+{
+  FIL record;
+  UINT written_bytes;
+  FRESULT fresult = f_open( &record, LOG_RESERVATION_FILE, FA_CREATE_ALWAYS | FA_WRITE);
+  if( fresult != FR_OK)
+    return fresult;
+  fresult = f_write( &record, file_name, strlen( file_name), &written_bytes);
+  f_close( &record);
+  return fresult;
+}
+
+FRESULT reserve_log_file( FIL * file, FSIZE_t size, DWORD * cluster_map)
+{
+  FRESULT fresult = f_expand( file, size, 1);
+  if( fresult != FR_OK)
+    return fresult;
+
+  // keep the chain but not the size: after a power loss the directory entry
+  // shall only cover data written and synced, not stale card content
+  file->obj.objsize = 0;
+
+  // contiguous chain: one fragment, no need to walk the FAT
+  DWORD cluster_bytes = (DWORD)file->obj.fs->csize * file->obj.fs->ssize;
+  cluster_map[0] = 4;
+  cluster_map[1] = (size + cluster_bytes - 1) / cluster_bytes;
+  cluster_map[2] = file->obj.sclust;
+  cluster_map[3] = 0;
+  file->cltbl = cluster_map; // use fast seek mode while inside of the reserved area
+
+  // directory entry now holds the start cluster, the chain can be found after a power loss
+  return f_sync( file);
+}
+
+//!< f_truncate only frees clusters if the file pointer is below the size
+static FRESULT truncate_cluster_chain( FIL * file)
+{
+  file->cltbl = 0;
+  file->obj.objsize = f_tell( file) + 1;
+  return f_truncate( file);
+}
+
+FRESULT close_log_file( FIL * file)
+{
+  FRESULT fresult = truncate_cluster_chain( file);
+  FRESULT close_result = f_close( file);
+  if( fresult == FR_OK)
+    fresult = close_result;
+  if( fresult == FR_OK)
+    fresult = f_unlink( LOG_RESERVATION_FILE);
+  return fresult == FR_NO_FILE ? FR_OK : fresult;
+}
+
+FRESULT reclaim_log_file_reservation( void)
+{
+  FIL file;
+  TCHAR file_name[ 64];
+  UINT read_bytes;
+
+  FRESULT fresult = f_open( &file, LOG_RESERVATION_FILE, FA_READ);
+  if( fresult == FR_NO_FILE)
+    return FR_OK; // the last log file has been closed properly
+  if( fresult != FR_OK)
+    return fresult;
+  fresult = f_read( &file, file_name, sizeof( file_name) - 1, &read_bytes);
+  f_close( &file);
+  if( fresult != FR_OK)
+    return fresult;
+  file_name[ read_bytes] = 0;
+
+  fresult = f_open( &file, file_name, FA_OPEN_EXISTING | FA_WRITE);
+  if( fresult == FR_OK)
+    {
+      fresult = f_lseek( &file, f_size( &file)); // behind the data synced before the power loss
+      if( fresult == FR_OK)
+	fresult = close_log_file( &file);
+      else
+	f_close( &file);
+      return fresult;
+    }
+
+  if( fresult == FR_NO_FILE) // not created or removed meanwhile
+    fresult = f_unlink( LOG_RESERVATION_FILE);
+  return fresult;
+}
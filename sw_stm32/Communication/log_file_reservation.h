@@ -0,0 +1,53 @@
+/***********************************************************************//**
+ * @file		log_file_reservation.h
+ * @brief		contiguous log file pre-allocation, released at close or at the next boot
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#ifndef LOG_FILE_RESERVATION_H_
+#define LOG_FILE_RESERVATION_H_
+
+#include "ff.h"
+
+//! holds the name of the log file with a pre-allocated cluster chain while it is open
+#define LOG_RESERVATION_FILE "logger/reserved.txt"
+
+/*!
+ The pre-allocated chain is longer than the directory entry size while the file is open.
+ After a power loss the clusters behind the synced size would be lost for good,
+ so the file name is recorded before the chain is allocated and removed after close.
+ reclaim_log_file_reservation() frees the remainder at the next boot.
+ FatFs only, this file has no further target dependencies.
+ */
+
+//! remember the log file name before its chain is allocated
+FRESULT record_log_file_reservation( const TCHAR * file_name);
+
+//! allocate a contiguous chain of size bytes and prepare the fast seek table
+//! @param cluster_map 4 entries, the whole chain is one fragment
+FRESULT reserve_log_file( FIL * file, FSIZE_t size, DWORD * cluster_map);
+
+//! free the clusters behind the file pointer, close the file and forget the reservation
+FRESULT close_log_file( FIL * file);
+
+//! boot: release the chain left behind by a log file that has not been closed
+FRESULT reclaim_log_file_reservation( void);
+
+#endif /* LOG_FILE_RESERVATION_H_ */
@@ -0,0 +1,113 @@
+/***********************************************************************//**
+ * @file		log_rate_scheduler.h
+ * @brief		per record type decimation of the log file content
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#ifndef LOG_RATE_SCHEDULER_H_
+#define LOG_RATE_SCHEDULER_H_
+
+#include "stdint.h"
+#include "string.h"
+
+//! periodically logged streams
+//! sensor data, magnetometer and statistics are counted in 100 Hz ticks,
+//! GNSS streams in GNSS updates, D_GNSS_ACC in D_GNSS_DATA records
+enum log_stream_t
+{
+  LOG_STREAM_SENSOR,
+  LOG_STREAM_MAGNETOMETER,
+  LOG_STREAM_GNSS,
+  LOG_STREAM_D_GNSS_ACC,
+  LOG_STREAM_STATISTICS,
+  LOG_STREAM_COUNT
+};
+
+//! mnemonics as used in the rates file, named after the record types
+inline const char * log_stream_name( unsigned stream)
+{
+  static const char * const name[ LOG_STREAM_COUNT] =
+    { "BASIC_SENSOR_DATA", "MAGNETOMETER_DATA", "GNSS_DATA", "D_GNSS_ACC", "LOG_STATISTICS" };
+  return stream < LOG_STREAM_COUNT ? name[ stream] : 0;
+}
+
+//! @return stream matching the start of text or LOG_STREAM_COUNT
+inline unsigned find_log_stream( const char * text)
+{
+  for( unsigned stream = 0; stream < LOG_STREAM_COUNT; ++stream)
+    {
+      const char * name = log_stream_name( stream);
+      size_t length = strlen( name);
+      if( ( strncmp( text, name, length) == 0) &&
+	  ( ( text[length] <= ' ') || ( text[length] == '=')))
+	return stream;
+    }
+  return LOG_STREAM_COUNT;
+}
+
+/*!
+ Decides which stream has to be logged at this occasion.
+ Decimation n: log every n-th occasion, 0: never.
+ After restart() every enabled stream is logged at its first occasion.
+ No target dependencies: the pattern and data rate of a profile can be checked on a host.
+ */
+class log_rate_scheduler_t
+{
+public:
+  log_rate_scheduler_t( const uint16_t * _decimation)
+  {
+    set_profile( _decimation);
+  }
+
+  void set_profile( const uint16_t * _decimation)
+  {
+    for( unsigned i = 0; i < LOG_STREAM_COUNT; ++i)
+      decimation[i] = _decimation[i];
+    restart();
+  }
+
+  void restart( void)
+  {
+    for( unsigned i = 0; i < LOG_STREAM_COUNT; ++i)
+      countdown[i] = 1;
+  }
+
+  //! count one occasion of the stream
+  bool due( log_stream_t stream)
+  {
+    if( decimation[ stream] == 0)
+      return false;
+    if( --countdown[ stream] != 0)
+      return false;
+    countdown[ stream] = decimation[ stream];
+    return true;
+  }
+
+  uint16_t get_decimation( log_stream_t stream) const
+  {
+    return decimation[ stream];
+  }
+
+private:
+  uint16_t decimation[ LOG_STREAM_COUNT];
+  uint16_t countdown[ LOG_STREAM_COUNT];
+};
+
+#endif /* LOG_RATE_SCHEDULER_H_ */
@@ -0,0 +1,227 @@
+/***********************************************************************//**
+ * @file		log_slot_ring.h
+ * @brief		single-producer / single-consumer slot ring of the log file writer
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#ifndef LOG_SLOT_RING_H_
+#define LOG_SLOT_RING_H_
+
+#include "stdint.h"
+
+//! section within the ring buffer, split into two parts at a wrap-around
+typedef struct
+{
+  uint32_t * first;
+  unsigned first_words;
+  uint32_t * second;
+  unsigned second_words;
+} log_span_t;
+
+/*!
+ Ring of equally sized slots between one producer and one consumer task.
+ The producer fills the slot at write_pointer and publishes it when it is complete,
+ the consumer writes the completed slots to the uSD card and releases them.
+ If the producer catches up with the consumer the records started within the present slot
+ are dropped and counted as overrun. Records are lost as a whole, never torn:
+ the end of a record continued from the previous slot is kept.
+ This file has no target dependencies and can be used by host tools.
+ */
+class log_slot_ring_t
+{
+public:
+  log_slot_ring_t( uint32_t * _buffer, unsigned size_words, unsigned _slots)
+  : buffer( _buffer),
+    buffer_end( _buffer + size_words),
+    slots( _slots),
+    slot_size_words( size_words / _slots)
+  {
+    reset();
+  }
+
+  void reset( void)
+  {
+    slots_filled = 0;
+    slots_flushed = 0;
+    overruns = 0;
+    slot_start = write_pointer = buffer;
+    slot_end = buffer + slot_size_words;
+    record_floor = buffer;
+  }
+
+  //! start a record of size_words ( < one slot), to be written by reserve() and commit()
+  //! drops the records started within the present slot if it would run into a slot still in use
+  //! @return false if the record itself has to be dropped
+  bool make_room( unsigned size_words)
+  {
+    if( record_floor == 0)
+      record_floor = write_pointer; // first record starting within this slot
+
+    if( ( write_pointer + size_words < slot_end) || next_slot_available())
+      return true;
+
+    ++overruns;
+    write_pointer = record_floor;
+    return write_pointer + size_words < slot_end;
+  }
+
+  //! reserve size_words of a record accepted by make_room() for in-place serialization
+  //! a span reaching the slot end is only handed out if the next slot is available,
+  //! so commit() never drops data it has been given
+  //! @return span of zero size if the record has not been accepted
+  log_span_t reserve( unsigned size_words)
+  {
+    log_span_t span;
+
+    unsigned words_in_slot = slot_end - write_pointer;
+    if( size_words < words_in_slot)
+      {
+	span.first = write_pointer;
+	span.first_words = size_words;
+	span.second = 0;
+	span.second_words = 0;
+	return span;
+      }
+
+    if( not next_slot_available())
+      {
+	span.first = span.second = 0;
+	span.first_words = span.second_words = 0;
+	return span;
+      }
+
+    span.first = write_pointer;
+    span.first_words = words_in_slot;
+    span.second = next_slot( slot_start);
+    span.second_words = size_words - words_in_slot;
+    return span;
+  }
+
+  //! publish size_words previously obtained from reserve()
+  //! @return true if a slot has been completed and is waiting for the consumer
+  bool commit( unsigned size_words)
+  {
+    unsigned words_in_slot = slot_end - write_pointer;
+    if( size_words < words_in_slot)
+      {
+	write_pointer += size_words;
+	return false;
+      }
+
+    advance_slot();
+    write_pointer += size_words - words_in_slot;
+    return true;
+  }
+
+  //! position of the next word written in words since reset()
+  uint32_t get_position( void) const
+  {
+    return slots_filled * slot_size_words + ( write_pointer - slot_start);
+  }
+
+  //! partially filled slot of the producer
+  uint32_t * get_open_slot( void) const
+  {
+    return slot_start;
+  }
+
+  unsigned get_open_words( void) const
+  {
+    return write_pointer - slot_start;
+  }
+
+  //! oldest completed slot, consumer side
+  uint32_t * get_completed_slot( void) const
+  {
+    return slots_flushed == slots_filled ? 0 : buffer + ( slots_flushed % slots) * slot_size_words;
+  }
+
+  //! hand the slot returned by get_completed_slot() back to the producer
+  void release_slot( void)
+  {
+    __sync_synchronize(); // slot content consumed before it is released
+    ++slots_flushed;
+  }
+
+  //! number of completed slots waiting for the consumer
+  unsigned get_pending_slots( void) const
+  {
+    return slots_filled - slots_flushed;
+  }
+
+  //! number of slots released by the consumer since reset()
+  unsigned get_flushed_slots( void) const
+  {
+    return slots_flushed;
+  }
+
+  //! number of slots that had to be dropped because the consumer was too slow
+  unsigned get_overrun_count( void) const
+  {
+    return overruns;
+  }
+
+  unsigned get_slot_count( void) const
+  {
+    return slots;
+  }
+
+  unsigned get_slot_size_words( void) const
+  {
+    return slot_size_words;
+  }
+
+private:
+  bool next_slot_available( void) const
+  {
+    return slots_filled - slots_flushed < slots - 1;
+  }
+
+  uint32_t * next_slot( uint32_t * slot) const
+  {
+    return ( slot + 2 * slot_size_words > buffer_end) ? buffer : slot + slot_size_words;
+  }
+
+  //! switch the producer to the next slot, its availability has been checked by reserve()
+  void advance_slot( void)
+  {
+    __sync_synchronize(); // slot content complete before it is published
+    ++slots_filled;
+
+    slot_start = next_slot( slot_start);
+    slot_end = slot_start + slot_size_words;
+    write_pointer = slot_start;
+    record_floor = 0; // not known before the next record starts
+  }
+
+  uint32_t * const buffer;
+  uint32_t * const buffer_end;
+  const unsigned slots;
+  const unsigned slot_size_words;
+  uint32_t *slot_start;			//!< slot presently filled by the producer
+  uint32_t *slot_end;
+  uint32_t *write_pointer;
+  uint32_t *record_floor;		//!< first record start within the present slot, 0 = none yet
+  volatile unsigned slots_filled;	//!< written by the producer only
+  volatile unsigned slots_flushed;	//!< written by the consumer only
+  unsigned overruns;
+};
+
+#endif /* LOG_SLOT_RING_H_ */
@@ -0,0 +1,94 @@
+/***********************************************************************//**
+ * @file		log_snapshot.cpp
+ * @brief		low priority preparation of the log file configuration snapshot
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#include "system_configuration.h"
+#include "FreeRTOS_wrapper.h"
+#include "common.h"
+#include "string.h"
+#include "EEPROM_data_file_implementation.h"
+#include "flexible_log_file_implementation.h"
+#include "uSD_helpers.h"
+#include "log_snapshot.h"
+
+COMMON static log_snapshot_t snapshot;
+COMMON static Semaphore snapshot_request( 1, 0, (char *)"SNAPSHOT");
+COMMON static log_snapshot_sequence_t snapshot_sequence;
+
+void request_log_snapshot( void)
+{
+  snapshot_sequence.request();
+  snapshot_request.signal();
+}
+
+const log_snapshot_t * get_log_snapshot( void)
+{
+  return snapshot_sequence.is_ready() ? &snapshot : 0;
+}
+
+static void log_snapshot_runnable( void *)
+{
+  while( true)
+    {
+      snapshot_request.wait();
+      unsigned request = snapshot_sequence.begin();
+
+      snapshot.file_format_version =
+	  flexible_log_file_implementation_t::FLEXIBLE_LOG_FILE_FORMAT_VERSION;
+
+      // write hardware, firmware id and FLASH SHA256
+      memset( snapshot.description, 0, 32);
+      strcpy( (char *)snapshot.description, GIT_TAG_INFO); // fw string
+      extern  uint32_t UNIQUE_ID[4];
+      memcpy( snapshot.description+32, UNIQUE_ID, sizeof( uint32_t)*4); // hw ID
+      memcpy( snapshot.description+32+16, firmware_SHA256_digest, 32); // flash program SHA256 digest
+
+      // all valid EEPROM content packed as one flexible file record
+      EEPROM_file_system <LOWEST_UNUSED_EEPROM_ID> flash_data_file(
+	  (EEPROM_file_system_node *)snapshot.flash_data_copy,
+	  (EEPROM_file_system_node *)snapshot.flash_data_copy+FLASH_DATA_COPY_SIZE_WORDS);
+      flash_data_file.import_all_data( permanent_data_file, false);
+      snapshot.flash_data_size_words = flash_data_file.get_size()/sizeof(uint32_t);
+
+      snapshot_sequence.done( request);
+    }
+}
+
+#define STACKSIZE 256
+static uint32_t __ALIGNED(STACKSIZE*sizeof(uint32_t)) stack_buffer[STACKSIZE];
+
+static ROM TaskParameters_t p =
+  {
+    log_snapshot_runnable,
+    "SNAPSHOT",
+    STACKSIZE,
+    0,
+    LOG_SNAPSHOT_PRIORITY,
+    stack_buffer,
+    {
+      { COMMON_BLOCK, COMMON_SIZE,  portMPU_REGION_READ_WRITE },
+      { (void *)0x080C0000, 0x00040000, portMPU_REGION_READ_ONLY }, // EEPROM
+      { 0, 0, 0 }
+    }
+  };
+
+static RestrictedTask log_snapshot_task( p);
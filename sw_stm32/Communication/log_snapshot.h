@@ -0,0 +1,92 @@
+/***********************************************************************//**
+ * @file		log_snapshot.h
+ * @brief		configuration snapshot heading each log file and following configuration changes
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#ifndef LOG_SNAPSHOT_H_
+#define LOG_SNAPSHOT_H_
+
+#include "stdint.h"
+
+#define DESCRIPTION_SIZE_BYTES (32+sizeof( uint32_t)*4+32)
+#define FLASH_DATA_COPY_SIZE_WORDS 128
+
+//! content of the FILE_FORMAT_VERSION, LARUS_DESCRIPTION and EEPROM_FILE records
+typedef struct
+{
+  uint32_t file_format_version;
+  uint8_t description[DESCRIPTION_SIZE_BYTES]; //!< fw string, hw ID, flash program SHA256 digest
+  uint32_t flash_data_copy[FLASH_DATA_COPY_SIZE_WORDS];
+  unsigned flash_data_size_words;
+} log_snapshot_t;
+
+/*!
+ Request and preparation count of the snapshot.
+ A snapshot is ready only if it has been prepared after the latest request,
+ a request during the preparation makes the preparer run again.
+ Requests and readers are the communicator task, so the snapshot is not rewritten while it is read.
+ This file has no target dependencies and can be used by host tools.
+ */
+class log_snapshot_sequence_t
+{
+public:
+  log_snapshot_sequence_t( void)
+    : requested( 0), prepared( 0)
+  {}
+
+  void request( void)
+  {
+    ++requested;
+  }
+
+  //! preparer: @return the request the snapshot will be valid for
+  unsigned begin( void) const
+  {
+    return requested;
+  }
+
+  //! preparer: publish the content before the count
+  void done( unsigned request)
+  {
+    __sync_synchronize();
+    prepared = request;
+  }
+
+  bool is_ready( void) const
+  {
+    if( prepared != requested)
+      return false;
+    __sync_synchronize(); // snapshot content valid before it is used
+    return true;
+  }
+
+private:
+  volatile unsigned requested;
+  volatile unsigned prepared;
+};
+
+//! order a new snapshot, prepared by a low priority task
+void request_log_snapshot( void);
+
+//! @return snapshot prepared after the latest request or 0 if not ready yet
+const log_snapshot_t * get_log_snapshot( void);
+
+#endif /* LOG_SNAPSHOT_H_ */
@@ -0,0 +1,104 @@
+/***********************************************************************//**
+ * @file		log_statistics.h
+ * @brief		uSD logger performance statistics, logged as a record
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#ifndef LOG_STATISTICS_H_
+#define LOG_STATISTICS_H_
+
+#include "stdint.h"
+
+enum { LATENCY_BUCKETS = 20 }; //!< bucket n counts [2^n, 2^(n+1)) usec, the last one everything above
+
+inline unsigned latency_bucket( uint32_t usec)
+{
+  unsigned i = usec ? 31 - __builtin_clz( usec) : 0;
+  return i < LATENCY_BUCKETS ? i : LATENCY_BUCKETS - 1;
+}
+
+//! latency histogram, plain data as it is part of record payloads
+struct latency_histogram_t
+{
+  uint32_t bucket[ LATENCY_BUCKETS];
+
+  void reset( void)
+  {
+    for( unsigned i = 0; i < LATENCY_BUCKETS; ++i)
+      bucket[i] = 0;
+  }
+
+  void add( uint32_t usec)
+  {
+    ++bucket[ latency_bucket( usec)];
+  }
+
+  uint32_t get_total( void) const
+  {
+    uint32_t total = 0;
+    for( unsigned i = 0; i < LATENCY_BUCKETS; ++i)
+      total += bucket[i];
+    return total;
+  }
+
+  //! halve all counts: old samples lose weight
+  void decay( void)
+  {
+    for( unsigned i = 0; i < LATENCY_BUCKETS; ++i)
+      bucket[i] >>= 1;
+  }
+
+  //! @return upper bound of the bucket containing the given percentile, 0 if empty
+  uint32_t percentile( unsigned percent) const
+  {
+    uint32_t total = get_total();
+    if( total == 0)
+      return 0;
+    uint32_t limit = ( total * percent + 99) / 100;
+    uint32_t sum = 0;
+    for( unsigned i = 0; i < LATENCY_BUCKETS; ++i)
+      {
+	sum += bucket[i];
+	if( sum >= limit)
+	  return ( 2u << i) - 1;
+      }
+    return ( 2u << ( LATENCY_BUCKETS - 1)) - 1;
+  }
+};
+
+/*!
+ LOG_STATISTICS record payload.
+ All counters are cumulative since the file has been opened and are written by the uSD task only.
+ Other tasks read a copy published by the uSD task, see flexible_log_file_implementation_t::get_statistics().
+ Plot tools use the differences between records.
+ This file has no target dependencies and can be used by host tools.
+ */
+typedef struct
+{
+  latency_histogram_t write_latency;	//!< per slot f_write or raw multi-block write
+  latency_histogram_t sync_latency;	//!< f_sync
+  uint32_t max_write_usec;
+  uint32_t max_sync_usec;
+  uint32_t slots_written;
+  uint32_t peak_pending_slots;	//!< ring buffer fill level maximum
+  uint32_t overruns;		//!< slots dropped
+} log_statistics_t;
+
+#endif /* LOG_STATISTICS_H_ */
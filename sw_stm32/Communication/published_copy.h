@@ -0,0 +1,66 @@
+/***********************************************************************//**
+ * @file		published_copy.h
+ * @brief		lock free hand-over of a data structure from one writer task to readers
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#ifndef PUBLISHED_COPY_H_
+#define PUBLISHED_COPY_H_
+
+/*!
+ Double buffered copy: the writer fills the buffer not handed out,
+ readers retry if a publication has happened while they were copying.
+ This file has no target dependencies and can be used by host tools.
+ */
+template <class T> class published_copy_t
+{
+public:
+  published_copy_t( void)
+    : publications( 0)
+  {}
+
+  //! writer task only
+  void publish( const T & value)
+  {
+    copy[ ( publications + 1) & 1] = value;
+    __sync_synchronize(); // copy complete before it is handed out
+    ++publications;
+  }
+
+  //! any task
+  void read( T & target) const
+  {
+    unsigned sequence;
+    do
+      {
+	sequence = publications;
+	__sync_synchronize();
+	target = copy[ sequence & 1];
+	__sync_synchronize();
+      }
+    while( publications != sequence); // the next publication but one overwrites this buffer
+  }
+
+private:
+  T copy[2];
+  volatile unsigned publications;	//!< copy[ publications & 1] is the latest one
+};
+
+#endif /* PUBLISHED_COPY_H_ */
@@ -32,7 +32,9 @@
 #include "embedded_math.h"
 #include "read_configuration_file.h"
 #include "persistent_data.h"
+#include "log_rate_scheduler.h"
 #include "stdlib.h"
+#include "string.h"
 
 #define TEST_MODULE 0
 
@@ -48,6 +50,7 @@ bool is_number_start( char c)
   return (( c >= '0') && ( c <='9')) || ( c =='-') || ( c =='+');
 }
 
+//! line reader refilling its buffer from the file, no limit for the file size
 class ASCII_file_reader
 {
   enum { BUFLEN = 512 *2};
@@ -55,6 +58,7 @@ public:
   ASCII_file_reader( char * filename)
     : current(0),
       end(0),
+      file_open( false),
       eof(true)
   {
     FRESULT fresult;
@@ -62,49 +66,158 @@ public:
     if( fresult != FR_OK)
       return;
 
-    UINT bytesread;
-    fresult = f_read(&infile, file_buffer, BUFLEN, &bytesread);
-    if( (fresult != FR_OK) || (bytesread == 0))
-      return;
-
-    f_close( &infile);
+    file_open = true;
+    current = end = file_buffer;
+    eof = not refill();
+  }
 
-    end = file_buffer + bytesread;
-    current = file_buffer;
-    eof=false;
+  ~ASCII_file_reader( void)
+  {
+    if( file_open)
+      f_close( &infile);
   }
 
   // return true if next line read, false if EOF
+  // the line is terminated, lines longer than the buffer are skipped
   bool read_line( char * &target)
   {
-    if( eof)
-      return false;
-    target = current;
-    while( (current < end) && (*current != '\n'))
-      ++current;
-    while( (current < end) && (*current <= ' '))
-      ++current;
-    eof = current >= end;
-    return true;
+    while( not eof)
+      {
+	char * line_end = (char *)memchr( current, '\n', end - current);
+	if( line_end == 0)
+	  {
+	    if( end - current >= BUFLEN - 1) // line too long
+	      {
+		skip_rest_of_line();
+		continue;
+	      }
+	    if( not refill())
+	      {
+		if( current == end)
+		  {
+		    eof = true;
+		    return false;
+		  }
+		line_end = end; // last line without newline
+	      }
+	    else
+	      continue;
+	  }
+
+	*line_end = 0;
+	if( ( line_end > current) && ( line_end[-1] == '\r'))
+	  line_end[-1] = 0;
+	target = current;
+	current = line_end < end ? line_end + 1 : end;
+	return true;
+      }
+    return false;
   }
   bool is_eof( void)
   {
     return eof;
   }
 private:
+  //! move the unread part to the buffer start and read more, @return false if nothing more to read
+  bool refill( void)
+  {
+    unsigned remaining = end - current;
+    memmove( file_buffer, current, remaining);
+    current = file_buffer;
+    end = file_buffer + remaining;
+
+    UINT bytesread = 0;
+    // keep one byte for the termination of a last line without newline
+    UINT space = BUFLEN - 1 - remaining;
+    if( space == 0)
+      return false;
+    FRESULT fresult = f_read(&infile, end, space, &bytesread);
+    if( (fresult != FR_OK) || (bytesread == 0))
+      return false;
+    end += bytesread;
+    return true;
+  }
+
+  void skip_rest_of_line( void)
+  {
+    current = end = file_buffer;
+    while( refill())
+      {
+	char * line_end = (char *)memchr( current, '\n', end - current);
+	if( line_end)
+	  {
+	    current = line_end + 1;
+	    return;
+	  }
+	current = end;
+      }
+    eof = true;
+  }
+
   FIL infile;
   char file_buffer[BUFLEN];
   char * current;
   char * end;
+  bool file_open;
   bool eof;
 };
 
+//! hash table for the parameter mnemonics, built once per file read
+class parameter_name_table
+{
+  enum { SIZE = 128}; // power of 2, more than twice the number of parameters
+  static_assert( PERSISTENT_DATA_ENTRIES * 2 <= SIZE, "parameter name table too small");
+public:
+  parameter_name_table( void)
+  {
+    memset( slot, 0, sizeof( slot));
+    for( unsigned i = 0; i < PERSISTENT_DATA_ENTRIES; ++i)
+      {
+	const char * name = PERSISTENT_DATA[i].mnemonic;
+	unsigned index = hash( name, strlen( name));
+	while( slot[index])
+	  index = ( index + 1) & ( SIZE - 1);
+	slot[index] = i + 1;
+      }
+  }
+
+  //! @return parameter whose mnemonic is exactly the first token of text
+  const persistent_data_t * find( const char * text) const
+  {
+    unsigned length = 0;
+    while( ( text[length] > ' ') && ( text[length] != '='))
+      ++length;
+
+    unsigned index = hash( text, length);
+    while( slot[index])
+      {
+	const persistent_data_t * candidate = PERSISTENT_DATA + slot[index] - 1;
+	if( ( strncmp( candidate->mnemonic, text, length) == 0) && ( candidate->mnemonic[length] == 0))
+	  return candidate;
+	index = ( index + 1) & ( SIZE - 1);
+      }
+    return 0;
+  }
+
+private:
+  static unsigned hash( const char * text, unsigned length) // FNV-1a
+  {
+    uint32_t h = 2166136261u;
+    while( length--)
+      h = ( h ^ (uint8_t)*text++) * 16777619u;
+    return h & ( SIZE - 1);
+  }
+
+  uint8_t slot[ SIZE]; //!< PERSISTENT_DATA index + 1, 0 = empty
+};
+
 bool read_init_file( const char * filename)
 {
   ASCII_file_reader file_reader((char *)filename);
   if( file_reader.is_eof())
     return false;
 
+  parameter_name_table parameter_names;
   char *position;
 
   // get all readable configuration lines and program data into EEPROM
@@ -114,7 +227,7 @@ bool read_init_file( const char * filename)
       while( is_white( *position))
 	++position;
 
-      const persistent_data_t *persistent_parameter = find_parameter_from_name( position);
+      const persistent_data_t *persistent_parameter = parameter_names.find( position);
 
       if( persistent_parameter == 0) // unable to find parameter name
 	continue;
@@ -196,3 +309,38 @@ bool read_init_file( const char * filename)
 
   return true;
 }
+
+bool read_log_rates_file( const char * filename, uint16_t * decimation)
+{
+  ASCII_file_reader file_reader((char *)filename);
+  if( file_reader.is_eof())
+    return false;
+
+  char *position;
+  while( file_reader.read_line( position))
+    {
+      while( is_white( *position))
+	++position;
+
+      unsigned stream = find_log_stream( position);
+      if( stream == LOG_STREAM_COUNT)
+	continue;
+
+      position += strlen( log_stream_name( stream));
+      while( is_white( *position))
+	++position;
+      if( *position != '=')
+	continue;
+      ++position;
+      while( is_white( *position))
+	++position;
+
+      if( ( *position < '0') || ( *position > '9'))
+	continue;
+
+      unsigned value = atoi( position);
+      if( value <= 0xffff)
+	decimation[ stream] = value;
+    }
+  return true;
+}
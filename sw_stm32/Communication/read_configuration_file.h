@@ -25,6 +25,11 @@
 #ifndef SRC___READ_CONFIGURATION_FILE_H_
 #define SRC___READ_CONFIGURATION_FILE_H_
 
+#include "stdint.h"
+
 bool read_init_file( const char * filename);
 
+//! read lines "BASIC_SENSOR_DATA = 1" into the log decimation table
+bool read_log_rates_file( const char * filename, uint16_t * decimation);
+
 #endif /* SRC___READ_CONFIGURATION_FILE_H_ */
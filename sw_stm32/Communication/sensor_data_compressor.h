@@ -0,0 +1,259 @@
+/***********************************************************************//**
+ * @file		sensor_data_compressor.h
+ * @brief		lossless XOR compression of consecutive sensor records
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#ifndef SENSOR_DATA_COMPRESSOR_H_
+#define SENSOR_DATA_COMPRESSOR_H_
+
+#include "stdint.h"
+
+/*
+ Record layout ( 32 bit words):
+   word 0:	bit 31 = keyframe, bits 16..23 = channel count, bits 0..15 = sequence number
+   keyframe:	raw channel words
+   otherwise:	bit stream, MSB first, per channel XOR against the previous sample:
+		'0'				unchanged
+		'10' + bits			meaningful bits within the previous window
+		'11' + 5 bit lead + 5 bit (length-1) + bits	new window
+ The decoder has to start at a keyframe.
+ After a gap in the sequence numbers ( records lost) it waits for the next keyframe.
+ This file has no target dependencies and can be used by host tools.
+ */
+
+enum { COMPRESSOR_KEYFRAME_FLAG = 0x80000000 };
+
+//! sequential bit writer, MSB first
+class bit_writer_t
+{
+public:
+  bit_writer_t( uint32_t * target)
+    : next( target), accu( 0), bits( 0)
+  {}
+  void put( uint32_t value, unsigned size) // size <= 32
+  {
+    accu = ( accu << size) | ( size == 32 ? value : ( value & (( 1u << size) - 1)));
+    bits += size;
+    if( bits >= 32)
+      {
+	bits -= 32;
+	*next++ = (uint32_t)( accu >> bits);
+      }
+  }
+  uint32_t * flush( void)
+  {
+    if( bits)
+      *next++ = (uint32_t)( accu << ( 32 - bits));
+    bits = 0;
+    return next;
+  }
+private:
+  uint32_t * next;
+  uint64_t accu;
+  unsigned bits;
+};
+
+//! sequential bit reader, MSB first
+class bit_reader_t
+{
+public:
+  bit_reader_t( const uint32_t * source, const uint32_t * source_end)
+    : next( source), end( source_end), accu( 0), bits( 0)
+  {}
+  bool get( uint32_t &value, unsigned size) // size <= 32
+  {
+    if( bits < size)
+      {
+	if( next >= end)
+	  return false;
+	accu = ( accu << 32) | *next++;
+	bits += 32;
+      }
+    bits -= size;
+    value = (uint32_t)( accu >> bits) & ( size == 32 ? 0xffffffff : (( 1u << size) - 1));
+    return true;
+  }
+private:
+  const uint32_t * next;
+  const uint32_t * end;
+  uint64_t accu;
+  unsigned bits;
+};
+
+//! encoder for records of CHANNELS 32-bit words ( IEEE floats usually)
+template <unsigned CHANNELS, unsigned KEYFRAME_INTERVAL = 100> class sensor_data_compressor
+{
+public:
+  enum { MAX_SIZE_WORDS = 1 + CHANNELS}; // keyframe size, never exceeded
+
+  sensor_data_compressor( void)
+    : sequence( 0), countdown( 0)
+  {}
+
+  //! force a keyframe with the next record
+  void restart( void)
+  {
+    countdown = 0;
+  }
+
+  //! encode one record into target[ MAX_SIZE_WORDS]
+  //! @return size in words
+  unsigned encode( const uint32_t * data, uint32_t * target)
+  {
+    ++sequence;
+    if( countdown == 0)
+      return keyframe( data, target);
+
+    uint32_t candidate[ 1 + ( CHANNELS * 44 + 31) / 32]; // worst case 44 bits per channel
+    bit_writer_t out( candidate + 1);
+    for( unsigned i = 0; i < CHANNELS; ++i)
+      {
+	uint32_t x = data[i] ^ previous[i];
+	if( x == 0)
+	  {
+	    out.put( 0, 1);
+	    continue;
+	  }
+	unsigned leading = __builtin_clz( x);
+	unsigned trailing = __builtin_ctz( x);
+
+	if( ( window_size[i] > 0) && ( leading >= lead[i]) && ( lead[i] + window_size[i] + trailing >= 32))
+	  {
+	    out.put( 2, 2);
+	    out.put( x >> ( 32 - lead[i] - window_size[i]), window_size[i]);
+	  }
+	else
+	  {
+	    unsigned size = 32 - leading - trailing;
+	    out.put( 3, 2);
+	    out.put( leading, 5);
+	    out.put( size - 1, 5);
+	    out.put( x >> trailing, size);
+	    lead[i] = leading;
+	    window_size[i] = size;
+	  }
+	previous[i] = data[i];
+      }
+    unsigned size = out.flush() - candidate;
+    if( size >= MAX_SIZE_WORDS) // incompressible, keyframe is smaller
+      return keyframe( data, target);
+
+    candidate[0] = ( CHANNELS << 16) | ( sequence & 0xffff);
+    for( unsigned i = 0; i < size; ++i)
+      target[i] = candidate[i];
+    --countdown;
+    return size;
+  }
+
+private:
+  unsigned keyframe( const uint32_t * data, uint32_t * target)
+  {
+    target[0] = COMPRESSOR_KEYFRAME_FLAG | ( CHANNELS << 16) | ( sequence & 0xffff);
+    for( unsigned i = 0; i < CHANNELS; ++i)
+      {
+	target[i + 1] = previous[i] = data[i];
+	window_size[i] = 0;
+      }
+    countdown = KEYFRAME_INTERVAL - 1;
+    return MAX_SIZE_WORDS;
+  }
+
+  uint32_t previous[ CHANNELS];
+  uint8_t lead[ CHANNELS];
+  uint8_t window_size[ CHANNELS];
+  uint32_t sequence;
+  unsigned countdown;
+};
+
+//! decoder, counterpart of sensor_data_compressor
+template <unsigned CHANNELS> class sensor_data_decompressor
+{
+public:
+  sensor_data_decompressor( void)
+    : expected_sequence( 0), synchronized( false)
+  {}
+
+  //! decode one record
+  //! @return false if the record is damaged, follows a gap or no keyframe has been seen yet
+  bool decode( const uint32_t * record, unsigned size_words, uint32_t * data)
+  {
+    if( ( size_words == 0) || ((( record[0] >> 16) & 0xff) != CHANNELS))
+      return synchronized = false;
+
+    uint16_t sequence = record[0] & 0xffff;
+    bool continuous = ( sequence == expected_sequence);
+    expected_sequence = sequence + 1;
+
+    if( record[0] & COMPRESSOR_KEYFRAME_FLAG)
+      {
+	if( size_words != 1 + CHANNELS)
+	  return synchronized = false;
+	for( unsigned i = 0; i < CHANNELS; ++i)
+	  {
+	    data[i] = previous[i] = record[i + 1];
+	    window_size[i] = 0;
+	  }
+	return synchronized = true;
+      }
+
+    if( not ( synchronized && continuous)) // delta against a record we have not seen
+      return synchronized = false;
+
+    bit_reader_t in( record + 1, record + size_words);
+    uint32_t control, value, leading, size;
+    for( unsigned i = 0; i < CHANNELS; ++i)
+      {
+	if( not in.get( control, 1))
+	  return synchronized = false;
+	if( control != 0)
+	  {
+	    if( not in.get( control, 1))
+	      return synchronized = false;
+	    if( control != 0) // new window
+	      {
+		if( not ( in.get( leading, 5) && in.get( size, 5)))
+		  return synchronized = false;
+		lead[i] = leading;
+		window_size[i] = size + 1;
+		if( lead[i] + window_size[i] > 32)
+		  return synchronized = false;
+	      }
+	    else if( window_size[i] == 0)
+	      return synchronized = false;
+
+	    if( not in.get( value, window_size[i]))
+	      return synchronized = false;
+	    previous[i] ^= value << ( 32 - lead[i] - window_size[i]);
+	  }
+	data[i] = previous[i];
+      }
+    return true;
+  }
+
+private:
+  uint32_t previous[ CHANNELS];
+  uint8_t lead[ CHANNELS];
+  uint8_t window_size[ CHANNELS];
+  uint16_t expected_sequence;
+  bool synchronized;
+};
+
+#endif /* SENSOR_DATA_COMPRESSOR_H_ */
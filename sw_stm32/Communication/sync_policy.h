@@ -0,0 +1,140 @@
+/***********************************************************************//**
+ * @file		sync_policy.h
+ * @brief		uSD file sync scheduling based on measured card latency
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#ifndef SYNC_POLICY_H_
+#define SYNC_POLICY_H_
+
+#include "stdint.h"
+#include "log_statistics.h"
+
+enum { LATENCY_DECAY_COUNT = 256 }; //!< histogram samples kept before old ones lose weight
+
+//! rolling histogram: halve the counts when they get too many
+inline void add_rolling_latency( latency_histogram_t &histogram, uint32_t usec)
+{
+  histogram.add( usec);
+  if( histogram.get_total() >= LATENCY_DECAY_COUNT)
+    histogram.decay();
+}
+
+/*!
+ Decides after each flush if a file sync is due.
+ - the distance between syncs never exceeds max_interval slots ( data lost on power failure),
+   plus the slots written by the flush_buffer() call that reached the limit
+ - syncs are spaced such that their P95 time stays below 25% of the production time
+ - a due sync is deferred while it would probably overrun the ring buffer,
+   but not beyond the maximum interval
+ Time is passed in, so the policy can be fed with recorded card latency traces on a host.
+ */
+class sync_policy_t
+{
+public:
+  sync_policy_t( unsigned _slots, unsigned _max_interval)
+    : slots( _slots),
+      max_interval( _max_interval ? _max_interval : 1),
+      interval( max_interval),
+      slots_since_sync( 0),
+      last_flush_time( 0),
+      slot_period( 0)
+  {
+    write_latency.reset();
+    sync_latency.reset();
+  }
+
+  void restart( void)
+  {
+    slots_since_sync = 0;
+    last_flush_time = 0;
+  }
+
+  //! flush_buffer() took duration usec for slots_written slots, finished at now
+  void record_flush( uint32_t duration, unsigned slots_written, uint64_t now)
+  {
+    if( slots_written == 0)
+      return;
+    add_rolling_latency( write_latency, duration / slots_written);
+    slots_since_sync += slots_written;
+
+    if( last_flush_time != 0)
+      {
+	uint32_t period = (uint32_t)( now - last_flush_time) / slots_written;
+	slot_period = slot_period ? ( slot_period * 7 + period) / 8 : period;
+      }
+    last_flush_time = now;
+  }
+
+  void record_sync( uint32_t duration)
+  {
+    add_rolling_latency( sync_latency, duration);
+    slots_since_sync = 0;
+    update_interval();
+  }
+
+  bool sync_due( unsigned pending_slots) const
+  {
+    if( slots_since_sync < interval)
+      return false;
+    if( slots_since_sync >= max_interval)
+      return true; // enforce the data loss limit even at the cost of an overrun
+
+    // slots produced while syncing
+    uint32_t expected = slot_period ? sync_latency.percentile( 95) / slot_period + 1 : 1;
+    return pending_slots + expected < slots - 1;
+  }
+
+  unsigned get_interval( void) const
+  {
+    return interval;
+  }
+
+  const latency_histogram_t & get_write_latency( void) const
+  {
+    return write_latency;
+  }
+
+  const latency_histogram_t & get_sync_latency( void) const
+  {
+    return sync_latency;
+  }
+
+private:
+  void update_interval( void)
+  {
+    if( slot_period == 0)
+      return;
+    uint32_t cost = sync_latency.percentile( 95) * 4;
+    unsigned wanted = cost / slot_period + 1;
+    interval = wanted > max_interval ? max_interval : wanted;
+  }
+
+  const unsigned slots;
+  const unsigned max_interval;	//!< slots, from the tolerated data loss
+  unsigned interval;		//!< slots, present sync distance
+  unsigned slots_since_sync;
+  uint64_t last_flush_time;	//!< usec
+  uint32_t slot_period;		//!< usec, averaged production time of one slot
+  latency_histogram_t write_latency;
+  latency_histogram_t sync_latency;
+};
+
+#endif /* SYNC_POLICY_H_ */
@@ -42,9 +42,12 @@
 #include "system_state.h"
 #include "reminder_flag.h"
 #include "uSD_helpers.h"
+#include "sync_policy.h"
+#include "log_file_reservation.h"
 
 COMMON reminder_flag perform_after_landing_actions;
 COMMON reminder_flag write_configuration_data_now;
+COMMON reminder_flag log_file_opened;
 
 extern Semaphore setup_file_handling_completed;
 
@@ -61,8 +64,6 @@ extern RestrictedTask uSD_handler_task;
 //!< this executable takes care of all uSD reading and writing
 void uSD_handler_runnable (void*)
 {
-  make_firmware_digest();
-
 restart:
 
   HAL_SD_DeInit (&hsd);
@@ -132,6 +133,9 @@ restart:
   if( init_file_read)
     f_rename ("larus_sensor_config.ini", "larus_sensor_config.ini.used");
 
+  // optional log rate profile, kept on the card and applied at every boot
+  (void) read_log_rates_file( "larus_log_rates.ini", log_decimation);
+
   (void) ensure_EEPROM_parameter_integrity();
 
   drop_privileges(); // go protected
@@ -158,8 +162,23 @@ restart:
 	  write_crash_dump( user_initiated_reset);
 	}
 
+#if LOG_FILE_PREALLOCATION_MB
+  // release the pre-allocated area of a log file not closed before a power loss
+  (void) reclaim_log_file_reservation();
+#endif
+
+  // not needed before the first log file is opened, so the boot is not delayed
+  acquire_privileges(); // reading the complete flash program
+  make_firmware_digest();
+  drop_privileges();
+
   char out_filename[30];
 
+  extern uint64_t getTime_usec(void);
+  sync_policy_t sync_policy(
+      flex_file.get_slot_count(),
+      LOG_SYNC_MAX_LOSS_KB * 1024 / ( flex_file.get_slot_size_words() * sizeof( uint32_t)));
+
   // wait until a GNSS timestamp is available.
   while ( coordinates.sat_fix_type == 0)
     {
@@ -200,8 +219,8 @@ restart:
 	    }
 	}
 
-      write_configuration_data_now.set();
-      unsigned file_sync_counter = 0;
+      log_file_opened.set(); // the communicator writes the file header
+      sync_policy.restart();
 
       // repeat: fill buffer with data chunks, write it to uSD and copy remaining data to start of buffer
       // this logger loop is synchronized by the communicator object
@@ -215,11 +234,16 @@ restart:
 	      write_crash_dump( user_initiated_reset);
 	    }
 
+	  unsigned flushed_slots = flex_file.get_flushed_slots();
+	  uint64_t time = getTime_usec();
 	  success = flex_file.flush_buffer();
-	  if( ++file_sync_counter >= 8)
+	  uint64_t now = getTime_usec();
+	  sync_policy.record_flush( now - time, flex_file.get_flushed_slots() - flushed_slots, now);
+
+	  if( success && sync_policy.sync_due( flex_file.get_pending_slots()))
 	    {
-	      file_sync_counter = 0;
-	      success &= flex_file.sync_file();
+	      success = flex_file.sync_file();
+	      sync_policy.record_sync( getTime_usec() - now);
 	    }
 
 	  if( not success)
@@ -237,8 +261,7 @@ restart:
 
 	  if( perform_after_landing_actions.test_and_reset())
 	    {
-	      flex_file.block_input(); // avoid buffer overrun
-	      flex_file.close();
+	      flex_file.close(); // input already finished by the communicator
 
 	      delay(250); // just to be sure everything is written
 	      break; /* break inner while loop and start again, which will start a new set of logfiles */
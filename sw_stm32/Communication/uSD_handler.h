@@ -12,6 +12,7 @@ extern bool dump_sensor_readings;
 
 extern flexible_log_file_implementation_t flex_file;
 extern reminder_flag perform_after_landing_actions;
-extern reminder_flag write_configuration_data_now;
+extern reminder_flag write_configuration_data_now; //!< configuration changed
+extern reminder_flag log_file_opened; //!< a new log file needs its header
 
 #endif /* USD_HANDLER_H_ */
@@ -36,6 +36,7 @@
 #include "communicator.h"
 #include "system_state.h"
 #include "uSD_helpers.h"
+#include "firmware_digest_cache.h"
 
 COMMON char *crashfile;
 COMMON unsigned crashline;
@@ -260,14 +261,45 @@ emergency_exit:
 
 COMMON uint8_t firmware_SHA256_digest[32];
 
+//! cheap image fingerprint from the CRC unit, some milliseconds for the complete program
+static uint32_t firmware_image_crc( const uint32_t * begin, const uint32_t * end)
+{
+  __HAL_RCC_CRC_CLK_ENABLE();
+  CRC->CR = CRC_CR_RESET;
+  for( const uint32_t * word = begin; word < end; ++word)
+    CRC->DR = *word;
+  uint32_t crc = CRC->DR;
+  __HAL_RCC_CRC_CLK_DISABLE();
+  return crc;
+}
+
+// the parameter IDs are defined in persistent_data.h, the digest blob must stay clear of them
+static_assert( FIRMWARE_DIGEST_EEPROM_ID >= LOWEST_UNUSED_EEPROM_ID, "firmware digest EEPROM ID collides with a parameter ID");
+
+//! provide the SHA256 of the flash program, a full hash only after a firmware change
+//! must run privileged
 void make_firmware_digest( void)
 {
+  extern uint8_t * __fini_array_end;
+  uint8_t * image_start = (uint8_t *)0x08000000;
+  uint32_t image_size = __fini_array_end - image_start;
+  uint32_t image_crc = firmware_image_crc(
+      (const uint32_t *)image_start,
+      (const uint32_t *)( image_start + ( ( image_size + 3) & ~3)));
+
+  firmware_digest_record_t record;
+  if( read_blob( FIRMWARE_DIGEST_EEPROM_ID, sizeof( record) / sizeof( uint32_t), &record)
+      && firmware_digest_record_valid( record, image_crc, image_size))
+    {
+      memcpy( firmware_SHA256_digest, record.digest, sizeof( firmware_SHA256_digest));
+      return;
+    }
+
   SHA256 sha;
   sha.update( SHA_INITIALIZATION, sizeof( SHA_INITIALIZATION));
 
-  extern uint8_t * __fini_array_end;
   unsigned block_size = 1024;
-  for( uint8_t * block_start = (uint8_t *)0x08000000;  block_start < __fini_array_end; block_start += block_size)
+  for( uint8_t * block_start = image_start;  block_start < __fini_array_end; block_start += block_size)
     {
       uint8_t * block_end = block_start + block_size;
       if( block_end > __fini_array_end)
@@ -276,6 +308,11 @@ void make_firmware_digest( void)
       delay(1); // beware of our watchdog !
     }
   sha.make_digest(firmware_SHA256_digest);
+
+  record.image_crc = image_crc;
+  record.image_size = image_size;
+  memcpy( record.digest, firmware_SHA256_digest, sizeof( record.digest));
+  (void) write_blob( FIRMWARE_DIGEST_EEPROM_ID, sizeof( record) / sizeof( uint32_t), &record);
 }
 
 bool write_EEPROM_dump( const char * file_path)
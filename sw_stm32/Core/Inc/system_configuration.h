@@ -30,13 +30,22 @@
 
 #define DISALLOW_DOWNGRADE		1
 #define RUN_FLASH_WRITE_TESTER		0
-#define ANALYZE_WRITE_PERFORMANCE	0
-#define MEASURE_WRITE_TIME		0
+#define LOG_BUFFER_SLOTS		8 // number of uSD write slots within the logger buffer
+#define MEASURE_LOG_APPEND_CYCLES	0 // report DWT cycles of the BASIC_SENSOR_DATA append
+#define MEASURE_COMMUNICATOR_LOOP_TIME	0 // report the worst case 100 Hz loop time in usec
+#define LOG_FILE_PREALLOCATION_MB	256 // contiguous log file size reserved at open, 0 = off
+#define LOG_RAW_SD_STREAMING		0 // write log slots as raw multi-block transfers into the reserved area
+#define LOG_COMPRESSED_SENSOR_DATA	0 // XOR-compress BASIC_SENSOR_DATA, keyframe every 100 records
+#define LOG_INDEX_INTERVAL_S		10 // seconds between LOG_INDEX records, 0 = no index
+#define LOG_INDEX_FOOTER_ENTRIES	62 // index entries kept in RAM for the footer record
+#define LOG_SYNC_MAX_LOSS_KB		32 // maximum log data lost on power failure, bounds the f_sync interval
+#define LOG_STATISTICS_INTERVAL_S	60 // seconds between LOG_STATISTICS records
 
 #define USE_HARDWARE_EEPROM		1
+#define EEPROM_VALUE_CACHE		1 // RAM copy of float parameters, invalidated by every EEPROM write
+#define FIRMWARE_DIGEST_EEPROM_ID	((EEPROM_file_system_node::ID_t)0xF0) // SHA256 cache, outside the parameter ID range
 #define MEASURE_GNSS_REFRESH_TIME	0
 #define ACTIVATE_USB_NMEA		1
-#define CAN_RX_ERROR_REPORT		1
 #define CRASFILE_ON_USER_RESET		1
 
 #define RUN_GNSS			1
@@ -47,6 +56,8 @@
 #define RUN_MICROPHONE			0
 
 #define RUN_CAN_TESTER			0
+#define SPREAD_CAN_OUTPUT		1 // distribute the 10 Hz CAN frame set over the 100 Hz ticks
+#define CAN_TX_LOAD_BUDGET_PERCENT	40 // output frames are thinned out while our own transmissions exceed this bus share
 
 #define ACTIVATE_USART_1_NMEA		1
 #define ACTIVATE_USART_2_NMEA		1
@@ -77,6 +88,7 @@
 
 #define MAG_CALCULATOR_PRIORITY		STANDARD_TASK_PRIORITY
 #define EEPROM_WRITER_PRIORITY	 	STANDARD_TASK_PRIORITY
+#define LOG_SNAPSHOT_PRIORITY		STANDARD_TASK_PRIORITY
 
 // ISR priorities
 
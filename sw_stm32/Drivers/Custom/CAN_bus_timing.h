@@ -0,0 +1,36 @@
+/***********************************************************************//**
+ * @file		CAN_bus_timing.h
+ * @brief		CAN frame duration model for bus load accounting
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#ifndef CAN_BUS_TIMING_H_
+#define CAN_BUS_TIMING_H_
+
+#define CAN_BIT_RATE 1000000 //!< 42 MHz APB1 / prescaler 6 / 7 time quanta
+
+//! bits on the bus for a standard data frame including worst case stuffing and interframe space
+inline unsigned CAN_frame_bits( unsigned dlc)
+{
+  unsigned stuffed = 34 + 8 * dlc; // SOF, arbitration, control, data and CRC field are stuffed
+  return stuffed + ( stuffed - 1) / 4 + 13;
+}
+
+#endif /* CAN_BUS_TIMING_H_ */
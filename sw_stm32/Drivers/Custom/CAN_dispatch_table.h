@@ -0,0 +1,184 @@
+/***********************************************************************//**
+ * @file		CAN_dispatch_table.h
+ * @brief		subscription chains of the CAN distributor
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#ifndef CAN_DISPATCH_TABLE_H_
+#define CAN_DISPATCH_TABLE_H_
+
+#include "stdint.h"
+
+#define CAN_ID_COUNT 2048 //!< 11 bit standard IDs
+
+/*!
+ Subscription slots chained per exact ID or in the mask rule chain.
+ The distributor task is the only reader and does not lock.
+ Writers must serialize add() and retire(), publish a slot with a single store
+ and leave unlinked slots retired until the reader recycles them between two packets.
+ Needs static storage: all zero is the empty table.
+ This file has no target dependencies and can be used by host tools.
+ */
+template <class queue_t, unsigned SUBSCRIBERS>
+class CAN_dispatch_table_t
+{
+public:
+  enum { SLOT_FREE, SLOT_ACTIVE, SLOT_RETIRED };
+
+  //! link a new slot, false if all slots are in use
+  template <class entry_t>
+  bool add( const entry_t &that)
+  {
+    unsigned slot = 1;
+    while( ( slot <= SUBSCRIBERS) && ( subscriber[slot].state != SLOT_FREE))
+      ++slot;
+    if( slot > SUBSCRIBERS)
+      return false;
+
+    uint8_t &head = chain_head( that);
+    subscriber[slot].ID_mask = that.ID_mask;
+    subscriber[slot].ID_value = that.ID_value;
+    subscriber[slot].queue = that.queue;
+    subscriber[slot].drops = 0;
+    subscriber[slot].next = head;
+    subscriber[slot].state = SLOT_ACTIVE;
+    __sync_synchronize(); // slot complete before it becomes visible
+    head = slot;
+    return true;
+  }
+
+  //! unlink a matching slot, it stays retired until recycle()
+  template <class entry_t>
+  bool retire( const entry_t &that)
+  {
+    uint8_t *link = &chain_head( that);
+    while( *link != 0)
+      {
+	subscriber_t &s = subscriber[ *link];
+	if( matches( s, that))
+	  {
+	    // a packet being distributed right now may still reach the queue
+	    s.state = SLOT_RETIRED;
+	    *link = s.next;
+	    return true;
+	  }
+	link = &s.next;
+      }
+    return false;
+  }
+
+  template <class entry_t>
+  unsigned drop_count( const entry_t &that) const
+  {
+    for( unsigned slot = chain_head( that); slot != 0; slot = subscriber[slot].next)
+      if( matches( subscriber[slot], that))
+	return subscriber[slot].drops;
+    return 0;
+  }
+
+  /*!
+   Reader side between two packets: no traversal in progress.
+   Frees the retired slots and copies the active subscriptions.
+   @return number of active subscriptions written to active[]
+   */
+  template <class entry_t>
+  unsigned recycle( entry_t * active)
+  {
+    unsigned entries = 0;
+    for( unsigned slot = 1; slot <= SUBSCRIBERS; ++slot)
+      {
+	if( subscriber[slot].state == SLOT_RETIRED)
+	  subscriber[slot].state = SLOT_FREE;
+	else if( subscriber[slot].state == SLOT_ACTIVE)
+	  {
+	    active[entries].ID_mask = subscriber[slot].ID_mask;
+	    active[entries].ID_value = subscriber[slot].ID_value;
+	    active[entries].queue = subscriber[slot].queue;
+	    ++entries;
+	  }
+      }
+    return entries;
+  }
+
+  //! offer the packet to its ID chain and to the mask rules, packets refused by a queue are counted
+  template <class packet_t>
+  void distribute( const packet_t &p)
+  {
+    for( unsigned slot = exact_chain[ p.id & 0x7ff]; slot != 0; slot = subscriber[slot].next)
+      deliver( subscriber[slot], p);
+
+    for( unsigned slot = mask_rule_chain; slot != 0; slot = subscriber[slot].next)
+      if( (p.id & subscriber[slot].ID_mask) == subscriber[slot].ID_value)
+	deliver( subscriber[slot], p);
+  }
+
+  unsigned state( unsigned slot) const
+  {
+    return subscriber[slot].state;
+  }
+
+private:
+  typedef struct
+  {
+    uint16_t ID_mask;
+    uint16_t ID_value;
+    queue_t * queue;
+    uint32_t drops;	//!< packets lost as the queue was full
+    uint8_t next;	//!< next slot in the chain, 0 = end
+    uint8_t state;
+  } subscriber_t;
+
+  template <class entry_t>
+  static bool is_exact( const entry_t &that)
+  {
+    return ( ( that.ID_mask & 0x7ff) == 0x7ff) && ( that.ID_value < CAN_ID_COUNT);
+  }
+
+  template <class entry_t>
+  static bool matches( const subscriber_t &s, const entry_t &that)
+  {
+    return ( s.queue == that.queue) && ( s.ID_mask == that.ID_mask) && ( s.ID_value == that.ID_value);
+  }
+
+  template <class entry_t>
+  uint8_t & chain_head( const entry_t &that)
+  {
+    return is_exact( that) ? exact_chain[ that.ID_value] : mask_rule_chain;
+  }
+
+  template <class entry_t>
+  uint8_t chain_head( const entry_t &that) const
+  {
+    return is_exact( that) ? exact_chain[ that.ID_value] : mask_rule_chain;
+  }
+
+  template <class packet_t>
+  static void deliver( subscriber_t &s, const packet_t &p)
+  {
+    if( ! s.queue->send( p, 0)) // no wait
+      ++s.drops;
+  }
+
+  subscriber_t subscriber[ SUBSCRIBERS + 1]; // slot 0 unused
+  uint8_t exact_chain[ CAN_ID_COUNT];
+  uint8_t mask_rule_chain;
+};
+
+#endif /* CAN_DISPATCH_TABLE_H_ */
@@ -25,36 +25,53 @@
 #include "FreeRTOS_wrapper.h"
 #include "candriver.h"
 #include "CAN_distributor.h"
+#include "CAN_dispatch_table.h"
 
-#define CAN_LIST_SIZE 10
+#define CAN_SUBSCRIBERS 16
 
-COMMON CAN_distributor_entry CAN_distributor_list[CAN_LIST_SIZE];
+// the distributor task is the only reader and does not lock,
+// subscribers serialize their changes with the guard.
+COMMON static CAN_dispatch_table_t< Queue <CANpacket>, CAN_SUBSCRIBERS> dispatch_table;
+COMMON static Mutex subscription_guard( (char *)"CAN_SUBSCR");
+COMMON static volatile bool CAN_subscriptions_changed;
+COMMON static CAN_distributor_entry CAN_filter_input[ CAN_SUBSCRIBERS];
+COMMON static CAN_filter_setup_t CAN_filter_setup;
 
 bool subscribe_CAN_messages( const CAN_distributor_entry &that)
 {
-  for( unsigned i=0; i<CAN_LIST_SIZE; ++i)
-    {
-      if( CAN_distributor_list[i].queue == 0) // queue == 0 means: entry = empty
-	{
-	  CAN_distributor_list[i]=that;
-	  return true;
-	}
-    }
-  return false; // list already full
+  subscription_guard.lock();
+  bool added = dispatch_table.add( that);
+  if( added)
+    CAN_subscriptions_changed = true; // the privileged distributor task reprograms the hardware
+  subscription_guard.release();
+  return added;
 }
 
-static inline void distribute_CAN_packet(const CANpacket &p)
+bool unsubscribe_CAN_messages( const CAN_distributor_entry &that)
 {
-  for(unsigned i=0; i<CAN_LIST_SIZE; ++i)
-    {
-      if( CAN_distributor_list[i].queue ==0) // end of list
-	return;
-      if( (p.id & CAN_distributor_list[i].ID_mask) == CAN_distributor_list[i].ID_value)
-	{
-	bool ok = CAN_distributor_list[i].queue->send( p, NO_WAIT);
-	ASSERT( ok);
-	}
-    }
+  subscription_guard.lock();
+  bool retired = dispatch_table.retire( that);
+  if( retired)
+    CAN_subscriptions_changed = true;
+  subscription_guard.release();
+  return retired;
+}
+
+unsigned get_CAN_drop_count( const CAN_distributor_entry &that)
+{
+  return dispatch_table.drop_count( that);
+}
+
+//! runs in the distributor task between two packets: no traversal in progress
+static void update_subscriptions( void)
+{
+  subscription_guard.lock();
+  unsigned entries = dispatch_table.recycle( CAN_filter_input);
+  subscription_guard.release();
+
+  // hardware acceptance filters from the present subscriptions
+  (void) make_CAN_filter_setup( CAN_filter_input, entries, CAN_filter_setup);
+  CAN_driver.set_filters( CAN_filter_setup);
 }
 
 void CAN_RX_task_code (void*)
@@ -62,8 +79,13 @@ void CAN_RX_task_code (void*)
   CANpacket p;
   while (1)
     {
-      CAN_driver.receive( p);
-      distribute_CAN_packet(p);
+      if( CAN_subscriptions_changed)
+	{
+	  CAN_subscriptions_changed = false;
+	  update_subscriptions();
+	}
+      if( CAN_driver.receive( p, 100)) // timeout: pick up new subscriptions
+	dispatch_table.distribute( p);
     }
 }
 
@@ -17,6 +17,11 @@ typedef struct
   Queue <CANpacket> * queue;
 } CAN_distributor_entry;
 
+//! deliver packets with ( id & ID_mask) == ID_value to the queue, several subscribers per ID allowed
 bool subscribe_CAN_messages( const CAN_distributor_entry &that);
+//! remove a subscription made with the same entry
+bool unsubscribe_CAN_messages( const CAN_distributor_entry &that);
+//! packets not delivered to this subscription as its queue was full
+unsigned get_CAN_drop_count( const CAN_distributor_entry &that);
 
 #endif /* CAN_DISTRIBUTOR_H_ */
@@ -0,0 +1,157 @@
+/***********************************************************************//**
+ * @file		CAN_filter_banks.h
+ * @brief		bxCAN acceptance filter setup from CAN subscriptions
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#ifndef CAN_FILTER_BANKS_H_
+#define CAN_FILTER_BANKS_H_
+
+#include "stdint.h"
+#include "CAN_bus_timing.h"
+
+#define CAN_FILTER_BANKS 14 //!< CAN1 share of the 28 bxCAN filter banks
+
+//! one bank in 16 bit scale, register contents FxR1 and FxR2
+typedef struct
+{
+  bool list_mode; //!< true: four exact IDs, false: two ID / mask pairs
+  uint32_t FR1;
+  uint32_t FR2;
+} CAN_filter_bank_t;
+
+typedef struct
+{
+  unsigned bank_count;
+  CAN_filter_bank_t bank[ CAN_FILTER_BANKS];
+} CAN_filter_setup_t;
+
+//! 16 bit filter field: STDID in bits 15..5, RTR and IDE zero = standard data frame
+inline uint32_t CAN_filter_field( uint16_t id)
+{
+  return (uint32_t)( id & 0x7ff) << 5;
+}
+
+//! mask field, RTR and IDE always compared:
+//! remote and extended frames never pass, the software only handles standard data frames
+inline uint32_t CAN_filter_mask_field( uint16_t mask)
+{
+  return CAN_filter_field( mask) | 0x18;
+}
+
+//! one bank in mask mode comparing RTR and IDE only: every standard data frame passes
+inline void set_CAN_filter_accept_all( CAN_filter_setup_t &setup)
+{
+  setup.bank_count = 1;
+  setup.bank[0].list_mode = false;
+  setup.bank[0].FR1 = CAN_filter_mask_field( 0) << 16;
+  setup.bank[0].FR2 = CAN_filter_mask_field( 0) << 16;
+}
+
+/*!
+ Upper bound of the RX interrupt rate: frames per second on a fully loaded bus.
+ At 1 Mbit/s about 7400 frames with 8 data bytes or 18000 without data,
+ one FIFO 0 interrupt each without filters.
+ With filters only subscribed IDs interrupt, e.g. 66 of 2048 standard IDs
+ for the CAN listener subscriptions, about 3% of the frames of evenly spread IDs.
+ */
+inline unsigned CAN_max_frame_rate( unsigned dlc)
+{
+  return CAN_BIT_RATE / CAN_frame_bits( dlc);
+}
+
+/*!
+ Turns subscriptions ( p.id & ID_mask) == ID_value into filter banks.
+ Exact IDs are packed four per bank in list mode, other rules two per bank in mask mode.
+ Subscriptions that can never match are skipped.
+ If the banks do not suffice, the setup falls back to accept-all, software still filters.
+ Remote ( RTR) and extended ( IDE) frames are rejected by all banks including accept-all.
+ Before, without hardware filters, they reached the RX ISR, which read the top 11 bits
+ of an extended ID as a standard ID and delivered RTR frames with stale data.
+ No target dependencies: allocation and rejection rates can be checked on a host.
+ @return false if the accept-all fallback has been used
+ */
+template <class entry_t>
+bool make_CAN_filter_setup( const entry_t * entry, unsigned entries, CAN_filter_setup_t &setup)
+{
+  uint16_t exact[ CAN_FILTER_BANKS * 4];
+  unsigned exact_count = 0;
+  uint16_t rule_value[ CAN_FILTER_BANKS * 2];
+  uint16_t rule_mask[ CAN_FILTER_BANKS * 2];
+  unsigned rule_count = 0;
+
+  for( unsigned i = 0; i < entries; ++i)
+    {
+      uint16_t value = entry[i].ID_value;
+      uint16_t mask = entry[i].ID_mask;
+      if( ( value & ~mask) || ( value > 0x7ff))
+	continue; // never matches a standard ID
+
+      if( ( mask & 0x7ff) == 0x7ff)
+	{
+	  bool known = false;
+	  for( unsigned k = 0; k < exact_count; ++k)
+	    known |= ( exact[k] == value);
+	  if( known)
+	    continue;
+	  if( exact_count == CAN_FILTER_BANKS * 4)
+	    goto accept_all;
+	  exact[ exact_count++] = value;
+	}
+      else
+	{
+	  if( rule_count == CAN_FILTER_BANKS * 2)
+	    goto accept_all;
+	  rule_value[ rule_count] = value;
+	  rule_mask[ rule_count] = mask;
+	  ++rule_count;
+	}
+
+      if( ( exact_count + 3) / 4 + ( rule_count + 1) / 2 > CAN_FILTER_BANKS)
+	goto accept_all;
+    }
+
+  setup.bank_count = 0;
+  for( unsigned i = 0; i < exact_count; i += 4)
+    {
+      CAN_filter_bank_t &bank = setup.bank[ setup.bank_count++];
+      uint32_t field[4];
+      for( unsigned k = 0; k < 4; ++k) // unused entries repeat the last ID
+	field[k] = CAN_filter_field( exact[ i + k < exact_count ? i + k : exact_count - 1]);
+      bank.list_mode = true;
+      bank.FR1 = field[0] | ( field[1] << 16);
+      bank.FR2 = field[2] | ( field[3] << 16);
+    }
+  for( unsigned i = 0; i < rule_count; i += 2)
+    {
+      CAN_filter_bank_t &bank = setup.bank[ setup.bank_count++];
+      unsigned second = i + 1 < rule_count ? i + 1 : i;
+      bank.list_mode = false;
+      bank.FR1 = CAN_filter_field( rule_value[i])      | ( CAN_filter_mask_field( rule_mask[i]) << 16);
+      bank.FR2 = CAN_filter_field( rule_value[second]) | ( CAN_filter_mask_field( rule_mask[second]) << 16);
+    }
+  return true;
+
+accept_all:
+  set_CAN_filter_accept_all( setup);
+  return false;
+}
+
+#endif /* CAN_FILTER_BANKS_H_ */
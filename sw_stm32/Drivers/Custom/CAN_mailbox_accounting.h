@@ -0,0 +1,89 @@
+/***********************************************************************//**
+ * @file		CAN_mailbox_accounting.h
+ * @brief		bxCAN mailbox handling of the interrupts with statistics
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#ifndef CAN_MAILBOX_ACCOUNTING_H_
+#define CAN_MAILBOX_ACCOUNTING_H_
+
+#include "stdint.h"
+#include "CAN_bus_timing.h"
+#include "CAN_statistics.h"
+
+//! bxCAN status bits, peripheral_t is CAN_TypeDef on the target or a model on a host
+enum
+{
+  CAN_TX_REQUEST_COMPLETED = 0x01,	//!< TSR RQCP0, repeated every 8 bits per mailbox
+  CAN_TX_OK = 0x02,			//!< TSR TXOK0
+  CAN_RX_FIFO_OVERRUN = 0x10,		//!< RF0R FOVR0, write 1 to clear
+  CAN_RX_FIFO_RELEASE = 0x20		//!< RF0R RFOM0
+};
+
+/*!
+ RX FIFO 0 interrupt: take the oldest frame to the queue and count it.
+ The release is a read-modify-write of RF0R: a pending overrun flag is written back as one
+ and cleared with it, so every overrun event is counted once.
+ This file has no target dependencies and can be used by host tools.
+ */
+template <class packet_t, class peripheral_t, class queue_t>
+inline void receive_CAN_FIFO0( peripheral_t &can, const queue_t &queue, CAN_statistics_t &statistics)
+{
+  packet_t msg;
+
+  msg.id = 0x07FF & (uint16_t) (can.sFIFOMailBox[0].RIR >> 21);
+  msg.dlc = (uint8_t) 0x0F & can.sFIFOMailBox[0].RDTR;
+  msg.data_w[0] = can.sFIFOMailBox[0].RDLR;
+  msg.data_w[1] = can.sFIFOMailBox[0].RDHR;
+
+  ++statistics.rx_frames[ CAN_id_class( msg.id)];
+  if( can.RF0R & CAN_RX_FIFO_OVERRUN) // cleared with the FIFO release below
+    ++statistics.rx_fifo_overruns;
+
+  if( ! queue.send_from_ISR( msg)) // reported through the CAN statistics, no trap in flight
+    ++statistics.rx_queue_overruns;
+  can.RF0R |= CAN_RX_FIFO_RELEASE; // release FIFO 0
+}
+
+/*!
+ TX interrupt: account the mailboxes transmitted successfully and acknowledge all completed ones.
+ Aborted requests ( RQCP without TXOK) are acknowledged without being counted.
+ @return bits put on the bus
+ */
+template <class peripheral_t>
+inline uint32_t complete_CAN_mailboxes( peripheral_t &can, CAN_statistics_t &statistics,
+					const uint32_t * mailbox_time, uint32_t now)
+{
+  uint32_t status = can.TSR;
+  uint32_t bits = 0;
+  for( unsigned mailbox = 0; mailbox < 3; ++mailbox)
+    {
+      uint32_t mailbox_status = status >> ( 8 * mailbox);
+      if( ( mailbox_status & ( CAN_TX_REQUEST_COMPLETED | CAN_TX_OK)) != ( CAN_TX_REQUEST_COMPLETED | CAN_TX_OK))
+	continue;
+      bits += CAN_frame_bits( can.sTxMailBox[mailbox].TDTR & 0x0F);
+      ++statistics.tx_frames[ CAN_id_class( can.sTxMailBox[mailbox].TIR >> 21)];
+      record_CAN_tx_latency( statistics, now - mailbox_time[mailbox]);
+    }
+  can.TSR = status & ( CAN_TX_REQUEST_COMPLETED * 0x010101); // acknowledge completed mailboxes
+  return bits;
+}
+
+#endif /* CAN_MAILBOX_ACCOUNTING_H_ */
@@ -0,0 +1,133 @@
+/***********************************************************************//**
+ * @file		CAN_priority_queue.h
+ * @brief		bounded CAN transmit queue ordered by CAN ID
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#ifndef CAN_PRIORITY_QUEUE_H_
+#define CAN_PRIORITY_QUEUE_H_
+
+#include "stdint.h"
+
+/*!
+ Binary heap of CAN packets, lowest ID = highest bus priority first,
+ packets with the same ID leave in the order they came in.
+ No locking: the user has to keep other tasks and the TX interrupt away while calling.
+ No target dependencies: queueing latencies can be measured on a host.
+ */
+template <class packet_t, unsigned SIZE>
+class CAN_priority_queue_t
+{
+public:
+  CAN_priority_queue_t( void)
+    : count( 0),
+      sequence( 0)
+  {}
+
+  //! @param time enqueue time stamp, returned by pop() but not interpreted
+  bool push( const packet_t &packet, uint32_t time = 0)
+  {
+    if( count >= SIZE)
+      return false;
+
+    unsigned position = count++;
+    item_t item = { packet, time, sequence++};
+
+    while( position > 0) // sift up
+      {
+	unsigned parent = ( position - 1) / 2;
+	if( ! before( item, heap[ parent]))
+	  break;
+	heap[ position] = heap[ parent];
+	position = parent;
+      }
+    heap[ position] = item;
+    return true;
+  }
+
+  bool pop( packet_t &packet)
+  {
+    uint32_t time;
+    return pop( packet, time);
+  }
+
+  bool pop( packet_t &packet, uint32_t &time)
+  {
+    if( count == 0)
+      return false;
+
+    packet = heap[0].packet;
+    time = heap[0].time;
+    item_t last = heap[ --count];
+
+    unsigned position = 0;
+    while( true) // sift down
+      {
+	unsigned child = 2 * position + 1;
+	if( child >= count)
+	  break;
+	if( ( child + 1 < count) && before( heap[ child + 1], heap[ child]))
+	  ++child;
+	if( ! before( heap[ child], last))
+	  break;
+	heap[ position] = heap[ child];
+	position = child;
+      }
+    heap[ position] = last;
+    return true;
+  }
+
+  unsigned get_count( void) const
+  {
+    return count;
+  }
+
+  bool is_empty( void) const
+  {
+    return count == 0;
+  }
+
+  bool is_full( void) const
+  {
+    return count >= SIZE;
+  }
+
+private:
+  typedef struct
+  {
+    packet_t packet;
+    uint32_t time;
+    uint16_t sequence; //!< arrival order, wraps around
+  } item_t;
+
+  //! sequence comparison is wrap-safe as long as less than 32768 packets are queued
+  static bool before( const item_t &a, const item_t &b)
+  {
+    if( a.packet.id != b.packet.id)
+      return a.packet.id < b.packet.id;
+    return (int16_t)( a.sequence - b.sequence) < 0;
+  }
+
+  item_t heap[ SIZE];
+  unsigned count;
+  uint16_t sequence;
+};
+
+#endif /* CAN_PRIORITY_QUEUE_H_ */
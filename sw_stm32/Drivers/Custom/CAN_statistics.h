@@ -0,0 +1,63 @@
+/***********************************************************************//**
+ * @file		CAN_statistics.h
+ * @brief		CAN bus health counters
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#ifndef CAN_STATISTICS_H_
+#define CAN_STATISTICS_H_
+
+#include "stdint.h"
+#include "log_statistics.h"
+
+#define CAN_ID_CLASSES 8 //!< frames are counted per 0x100 ID range
+
+inline unsigned CAN_id_class( uint16_t id)
+{
+  return ( id >> 8) & ( CAN_ID_CLASSES - 1);
+}
+
+/*!
+ CAN_STATISTICS record payload and CAN diagnostic response.
+ All counters are cumulative since power-on, each one is written by a single interrupt or task.
+ This file has no target dependencies and can be used by host tools.
+ */
+typedef struct
+{
+  uint32_t rx_frames[ CAN_ID_CLASSES];		//!< accepted by the filters
+  uint32_t tx_frames[ CAN_ID_CLASSES];		//!< transmitted successfully
+  latency_histogram_t tx_latency;		//!< send() to transmission complete
+  uint32_t max_tx_latency_usec;
+  uint32_t rx_fifo_overruns;			//!< frames lost in the hardware FIFO
+  uint32_t rx_queue_overruns;			//!< frames lost as the RX queue was full
+  uint32_t tx_queue_high_water;			//!< maximum TX queue fill level
+  uint32_t error_passive_events;
+  uint32_t bus_off_events;
+  uint32_t locked_ms;				//!< time without CAN after errors
+} CAN_statistics_t;
+
+inline void record_CAN_tx_latency( CAN_statistics_t &statistics, uint32_t usec)
+{
+  statistics.tx_latency.add( usec);
+  if( usec > statistics.max_tx_latency_usec)
+    statistics.max_tx_latency_usec = usec;
+}
+
+#endif /* CAN_STATISTICS_H_ */
@@ -5,6 +5,7 @@
 #include "system_configuration.h"
 #include "my_assert.h"
 #include "EEPROM_data_file_implementation.h"
+#include "flash_burst.h"
 #include "stm32f4xx_hal.h"
 
 #define PAGE_0_HEAD ((uint32_t *)0x080C0000)
@@ -15,11 +16,39 @@
 
 COMMON Queue <flash_write_order> flash_command_queue( 3, "FLASH_CMD");
 COMMON Semaphore flash_isr_to_task( 1, 0, (char *)"FLASH_ISR");
+COMMON Semaphore flash_erase_done( 1, 0, (char *)"FLASH_ERASED");
 COMMON Mutex_Wrapper_Type my_mutex( (char *)"MTX_WRAPPER");
 
 COMMON EEPROM_file_system <LOWEST_UNUSED_EEPROM_ID> permanent_data_file;
 extern Queue <flash_write_order> flash_command_queue;
 
+COMMON static flash_burst_t flash_burst; //!< see FLASH_IRQHandler
+extern FLASH_ProcessTypeDef pFlash; // HAL flash driver state
+
+//!< program n_words >= 1, the next word is started from the ISR, flash must be unlocked
+static bool FLASH_program_burst( uint32_t *dest, const uint32_t *source, unsigned n_words)
+{
+  bool valid = flash_burst.start( dest, source, n_words);
+  ASSERT( valid);
+
+  HAL_StatusTypeDef status = HAL_FLASH_Program_IT( TYPEPROGRAM_WORD, (uint32_t)dest, *source);
+  ASSERT( status == HAL_OK);
+
+  // typically 16us, at most about 100us per word, the timeout is meant for a hardware failure only
+  bool no_timeout = flash_isr_to_task.wait( FLASH_ACCESS_TIMEOUT + n_words / 10 + 1);
+  if( not no_timeout) // stop the chain before giving up, no further word must be started from the ISR
+    {
+      NVIC_DisableIRQ( FLASH_IRQn);
+      flash_burst.abort();
+      CLEAR_BIT( FLASH->CR, FLASH_CR_EOPIE | FLASH_CR_ERRIE);
+      pFlash.ProcedureOnGoing = FLASH_PROC_NONE;
+      NVIC_EnableIRQ( FLASH_IRQn);
+    }
+  ASSERT( no_timeout);
+
+  return not flash_burst.has_failed();
+}
+
 void FLASH_write (uint32_t *dest, uint32_t *source, unsigned n_words, bool synchronized)
 {
   if (not synchronized)
@@ -27,20 +56,14 @@ void FLASH_write (uint32_t *dest, uint32_t *source, unsigned n_words, bool synch
       while (n_words--)
 	  *dest++ = *source++;
     }
-  else // synchronous write, interrupt-synchronized
+  else if( n_words > 0) // synchronous write, interrupt-synchronized, one unlock for the whole block
     {
       HAL_StatusTypeDef status;
       status = HAL_FLASH_Unlock ();
       ASSERT(HAL_OK == status);
 
-      while (n_words--)
-	{
-	  status = HAL_FLASH_Program_IT ( TYPEPROGRAM_WORD, (uint32_t) dest++,
-					 *source++);
-	  ASSERT(status == HAL_OK);
-	  bool no_timeout = flash_isr_to_task.wait ( FLASH_ACCESS_TIMEOUT);
-	  ASSERT(no_timeout);
-	}
+      bool success = FLASH_program_burst( dest, source, n_words);
+      ASSERT( success);
 
       status = HAL_FLASH_Lock ();
       ASSERT(HAL_OK == status);
@@ -91,7 +114,9 @@ bool erase_sector( unsigned sector)
   bool result = flash_command_queue.send( cmd, FLASH_ERASE_TIMEOUT);
   ASSERT( result);
 
-  delay( MAXIMUM_PAGE_ERASE_TIME); // wait longest possible time until ERASE done
+  // typically 1..2s for 128 kB, wait for the writer task to report completion
+  result = flash_erase_done.wait( MAXIMUM_PAGE_ERASE_TIME + FLASH_ERASE_TIMEOUT);
+  ASSERT( result);
 
   return true;
 }
@@ -112,15 +137,83 @@ void erase_sector_operation( unsigned sector)
   ASSERT(status == HAL_OK);
 }
 
+#if EEPROM_VALUE_CACHE
+
+/*
+ Parameter values found by a flash search are kept in RAM together with a stamp
+ of the file system state. Any store changes the remaining space, whoever has written to the EEPROM file system.
+ A page transfer may bring back an old stamp with different contents, so it clears the whole cache.
+ No lock: values cached under the same stamp are identical, and the stamp is invalidated before
+ the value is written, so a reader seeing the same valid stamp before and after reading has a correct value.
+ */
+typedef struct
+{
+  volatile uint32_t stamp;
+  volatile float value;
+} EEPROM_cache_entry_t;
+
+COMMON static EEPROM_cache_entry_t EEPROM_cache[ LOWEST_UNUSED_EEPROM_ID];
+
+static uint32_t EEPROM_cache_stamp( void)
+{
+  uint32_t stamp = permanent_data_file.get_remaining_space_words() | 0x40000000;
+  if( permanent_data_file.get_head() == (void *)PAGE_1_HEAD)
+    stamp |= 0x80000000;
+  return stamp;
+}
+
+static void EEPROM_cache_invalidate( void)
+{
+  for( unsigned i = 0; i < LOWEST_UNUSED_EEPROM_ID; ++i)
+    EEPROM_cache[i].stamp = 0;
+}
+
+static bool EEPROM_cache_read( EEPROM_PARAMETER_ID id, uint32_t stamp, float &value)
+{
+  if( id >= LOWEST_UNUSED_EEPROM_ID)
+    return false;
+  EEPROM_cache_entry_t & entry = EEPROM_cache[id];
+  if( entry.stamp != stamp)
+    return false;
+  __DMB();
+  value = entry.value;
+  __DMB();
+  return entry.stamp == stamp;
+}
+
+static void EEPROM_cache_write( EEPROM_PARAMETER_ID id, uint32_t stamp, float value)
+{
+  if( id >= LOWEST_UNUSED_EEPROM_ID)
+    return;
+  EEPROM_cache_entry_t & entry = EEPROM_cache[id];
+  entry.stamp = 0;
+  __DMB();
+  entry.value = value;
+  __DMB();
+  entry.stamp = stamp;
+}
+
+#endif
+
 float configuration (EEPROM_PARAMETER_ID id)
 {
   if ( permanent_data_file.in_use())
     {
       float value;
+#if EEPROM_VALUE_CACHE
+      uint32_t stamp = EEPROM_cache_stamp();
+      if( EEPROM_cache_read( id, stamp, value))
+	return value;
+#endif
       // try to read float object size one
       bool result = permanent_data_file.retrieve_data (id, 1, (uint32_t *)&value);
       if (result)
-	return value;
+	{
+#if EEPROM_VALUE_CACHE
+	  EEPROM_cache_write( id, stamp, value);
+#endif
+	  return value;
+	}
       else // read direct data ( 8 bit) object
 	{
 	  uint8_t value;
@@ -137,7 +230,14 @@ float configuration (EEPROM_PARAMETER_ID id)
     }
 }
 
-bool file_system_page_swap( void)
+/*!
+ Copy all valid records to the spare page and make it the active one.
+ Both erases are synchronous. There is no background compaction: an erase on the
+ single-bank F407 stalls instruction fetches for 1..2s, and a resumable, slice-wise
+ import needs a page state marker in the EEPROM_file_system format (lib module).
+ Boot keeps the spare page erased, so a swap has to erase the obsolete page only.
+ */
+static bool transfer_to_spare_page( void)
 {
   if( permanent_data_file.get_head() == (void *)PAGE_1_HEAD)
     {
@@ -161,6 +261,15 @@ bool file_system_page_swap( void)
     }
 }
 
+bool file_system_page_swap( void)
+{
+  bool result = transfer_to_spare_page();
+#if EEPROM_VALUE_CACHE
+  EEPROM_cache_invalidate(); // stamps of the old page are meaningless now
+#endif
+  return result;
+}
+
 bool write_EEPROM_value (EEPROM_PARAMETER_ID id, float value)
 {
   ASSERT (permanent_data_file.in_use());
@@ -171,7 +280,19 @@ bool write_EEPROM_value (EEPROM_PARAMETER_ID id, float value)
 //!< interface to legacy read function
 bool read_EEPROM_value (EEPROM_PARAMETER_ID id, float &value)
 {
+#if EEPROM_VALUE_CACHE
+  uint32_t stamp = EEPROM_cache_stamp();
+  if( EEPROM_cache_read( id, stamp, value))
+    return false;
+
+  if( not permanent_data_file.retrieve_data( id, 1, &value))
+    return true;
+
+  EEPROM_cache_write( id, stamp, value);
+  return false;
+#else
   return not permanent_data_file.retrieve_data( id, 1, &value);
+#endif
 }
 
 bool import_raw_EEPROM_data( EEPROM_PARAMETER_ID id, uint32_t * flash_address, unsigned size_words, uint16_t &datum)
@@ -236,6 +357,10 @@ static bool import_legacy_EEPROM_data( uint32_t * flash_address, unsigned size_w
 
 void recover_and_initialize_flash( void)
 {
+#if EEPROM_VALUE_CACHE
+  EEPROM_cache_invalidate(); // the file system may be rebuilt below
+#endif
+
   if( *(uint16_t *)0x080F8000 == 0 && *(int64_t *)0x080E0000 == -1) // old flash layout
     {
       // prepare page 0 for data import
@@ -269,6 +394,8 @@ void recover_and_initialize_flash( void)
 	  // finally: if the file system is almost full: do a page swap right now
 	  if( permanent_data_file.get_remaining_space_words() < (PAGE_SIZE_WORDS - (PAGE_SIZE_WORDS >> 2)))
 	    file_system_page_swap();
+	  else
+	    erase_sector( 0); // keep the spare page ready, a swap in flight then needs no erase of the target
 	  return;
 	}
 
@@ -292,6 +419,8 @@ void recover_and_initialize_flash( void)
 	  // finally: if the file system is almost full: do a page swap right now
 	  if( permanent_data_file.get_remaining_space_words() < (PAGE_SIZE_WORDS - (PAGE_SIZE_WORDS >> 2)))
 	    file_system_page_swap();
+	  else
+	    erase_sector( 1); // keep the spare page ready, a swap in flight then needs no erase of the target
 	  return;
 	}
 
@@ -335,22 +464,24 @@ static void EEPROM_writing_runnable( void *)
 
       if( order.dest == 0) // erase commmand
 	{
+	  flash_burst.clear();
 	  erase_sector_operation( 0);
 	  no_timeout = flash_isr_to_task.wait( FLASH_ERASE_TIMEOUT);
 	  ASSERT( no_timeout);
+	  flash_erase_done.signal();
 	}
       else if( order.dest == (uint32_t *)1)
 	{
+	  flash_burst.clear();
 	  erase_sector_operation( 1);
 	  no_timeout = flash_isr_to_task.wait( FLASH_ERASE_TIMEOUT);
 	  ASSERT( no_timeout);
+	  flash_erase_done.signal();
 	}
       else
 	{
-	  status = HAL_FLASH_Program_IT( TYPEPROGRAM_WORD, (uint32_t)(order.dest), order.value);
-	  ASSERT( status == HAL_OK);
-	  no_timeout = flash_isr_to_task.wait( FLASH_ERASE_TIMEOUT);
-	  ASSERT( no_timeout);
+	  bool success = FLASH_program_burst( order.dest, &order.value, 1);
+	  ASSERT( success);
 	}
 
       status = HAL_FLASH_Lock();
@@ -378,12 +509,34 @@ static ROM TaskParameters_t p =
 
 static RestrictedTask EEPROM_accessor( p);
 
+//! the next word of a burst can only be started after the HAL has released the flash handle
 extern "C" void FLASH_IRQHandler( void)
 {
   HAL_FLASH_IRQHandler();
+
+  uint32_t * dest;
+  uint32_t value;
+  switch( flash_burst.step( dest, value))
+    {
+    case flash_burst_t::STEP_BUSY:
+      break;
+    case flash_burst_t::STEP_PROGRAM:
+      if( HAL_OK == HAL_FLASH_Program_IT( TYPEPROGRAM_WORD, (uint32_t)dest, value))
+	break;
+      flash_burst.program_refused();
+      // fall through
+    case flash_burst_t::STEP_DONE:
+      flash_isr_to_task.signal_from_ISR();
+      break;
+    }
 }
 
 extern "C" void HAL_FLASH_EndOfOperationCallback(uint32_t ReturnValue)
 {
-  flash_isr_to_task.signal_from_ISR();
+  flash_burst.end_of_operation();
+}
+
+extern "C" void HAL_FLASH_OperationErrorCallback(uint32_t ReturnValue)
+{
+  flash_burst.operation_error();
 }
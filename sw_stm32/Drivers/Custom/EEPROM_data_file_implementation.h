@@ -3,6 +3,9 @@
 
 #include "persistent_data_file.h"
 
+//! order for the EEPROM writer task
+//! dest 0 / 1: erase sector, else: program value to dest
+//! blocks are programmed by FLASH_write() in the caller's context
 typedef struct
 {
   uint32_t * dest;
@@ -26,6 +26,7 @@
 
 #include "generic_CAN_driver.h"
 #include "candriver.h"
+#include "CAN_mailbox_accounting.h"
 
 #include "stm32f4xx_hal.h"
 #include "stm32f4xx_hal_can.h"
@@ -52,7 +53,7 @@ extern "C" QueueHandle_t get_RX_queue( void)
 	return CAN_driver.get_RX_Queue().get_queue();
 }
 
-bool can_driver_t::send_can_packet (const CANpacket &msg)
+bool can_driver_t::send_can_packet (const CANpacket &msg, uint32_t time)
 {
   uint8_t transmitmailbox;
 
@@ -79,10 +80,29 @@ bool can_driver_t::send_can_packet (const CANpacket &msg)
   CANx->sTxMailBox[transmitmailbox].TDHR = msg.data_w[1];
 
   /* Request transmission */
+  mailbox_time[transmitmailbox] = time;
   CANx->sTxMailBox[transmitmailbox].TIR |= CAN_TI0R_TXRQ;
   return true;
 }
 
+//! keep all three mailboxes busy with the highest priority packets pending
+//! @return true if a packet has been moved to the hardware
+unsigned can_driver_t::fill_mailboxes( void)
+{
+  unsigned taken = 0;
+  CANpacket msg;
+  uint32_t time;
+  while( ( ( CANx->TSR & ( CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2)) != 0)
+      && TX_queue.pop( msg, time))
+    {
+      send_can_packet( msg, time);
+      ++taken;
+    }
+  return taken;
+}
+
+extern uint64_t getTime_usec_privileged(void);
+
 CAN_HandleTypeDef CanHandle;
 
 namespace CAN_driver_ISR
@@ -94,34 +114,40 @@ namespace CAN_driver_ISR
    */
   extern "C" void CAN1_RX0_IRQHandler (void)
   {
-    CANpacket msg;
-
-    msg.id = 0x07FF & (uint16_t) (CANx->sFIFOMailBox[0].RIR >> 21);
-    msg.dlc = (uint8_t) 0x0F & CANx->sFIFOMailBox[0].RDTR;
-    msg.data_w[0] = CANx->sFIFOMailBox[0].RDLR;
-    msg.data_w[1] = CANx->sFIFOMailBox[0].RDHR;
-
-    bool result = CAN_driver.RX_queue.send_from_ISR (msg);
-#if CAN_RX_ERROR_REPORT
-    ASSERT(result == true); // trap for RX queue overrun
-#endif
-    CANx->RF0R |= CAN_RF0R_RFOM0; // release FIFO 0
+    receive_CAN_FIFO0 <CANpacket> ( *CANx, CAN_driver.RX_queue, CAN_driver.statistics);
   }
 
   extern "C" void CAN1_TX_IRQHandler (void)
   {
-    CANpacket msg;
-    if (CAN_driver.TX_queue.receive_from_ISR (msg))
-      CAN_driver.send_can_packet (msg);
-    else
-      CANx->IER &= ~CAN_IT_TX_MAILBOX_EMPTY; // interrupt off, no more work to do
+    uint32_t now = (uint32_t)getTime_usec_privileged();
+    CAN_driver.tx_bits += complete_CAN_mailboxes( *CANx, CAN_driver.statistics, CAN_driver.mailbox_time, now);
+
+    unsigned taken = CAN_driver.fill_mailboxes();
+
+    // the interrupt stays enabled even with an empty queue: it only fires on RQCP,
+    // so every completion is accounted right away and the latency excludes idle time
+
+    // every free queue entry wakes one blocked sender, a single signal would leave the others waiting
+    for( ; ( taken > 0) && ( CAN_driver.tx_waiters > 0); --taken)
+      {
+	--CAN_driver.tx_waiters;
+	CAN_driver.TX_space.signal_from_ISR();
+      }
   }
 
   extern "C" void CAN1_SCE_IRQHandler( void)
   {
+    uint32_t error_status = CANx->ESR;
+    if( error_status & CAN_ESR_BOFF)
+      ++CAN_driver.statistics.bus_off_events;
+    if( error_status & CAN_ESR_EPVF)
+      ++CAN_driver.statistics.error_passive_events;
+
     CANx->IER = 0; // no more interrupts
     CANx->MSR = CAN_MSR_ERRI_Msk; // reset any pending error
     CAN_driver.locked = true;
+    CAN_driver.locked_by_error = true;
+    CAN_driver.lock_time = xTaskGetTickCountFromISR();
     CAN_driver.reset_timer.start_from_ISR();
   }
 
@@ -133,13 +159,50 @@ namespace CAN_driver_ISR
 
 can_driver_t::can_driver_t () :
     RX_queue (40,"CAN_RX"),
-    TX_queue (20,"CAN_TX"),
+    TX_space( CAN_TX_QUEUE_SIZE, 0, (char *)"CAN_TX"),
+    tx_waiters( 0),
     reset_timer( 10000, CAN_reset_timer_callback, false),
-    locked( true)
+    locked( true),
+    tx_bits( 0),
+    statistics{},
+    mailbox_time{},
+    lock_time( 0),
+    locked_by_error( false)
 {
+  set_CAN_filter_accept_all( filters); // until the subscriptions are known
   initialize();
 }
 
+void can_driver_t::program_filters( void)
+{
+  CANx->FMR = ( CANx->FMR & ~CAN_FMR_CAN2SB) | ( CAN_FILTER_BANKS << CAN_FMR_CAN2SB_Pos) | CAN_FMR_FINIT;
+  CANx->FA1R &= ~(( 1 << CAN_FILTER_BANKS) - 1);
+
+  for( unsigned i = 0; i < filters.bank_count; ++i)
+    {
+      uint32_t bit = 1 << i;
+      if( filters.bank[i].list_mode)
+	CANx->FM1R |= bit;
+      else
+	CANx->FM1R &= ~bit;
+      CANx->FS1R &= ~bit; // 16 bit scale
+      CANx->FFA1R &= ~bit; // FIFO 0
+      CANx->sFilterRegister[i].FR1 = filters.bank[i].FR1;
+      CANx->sFilterRegister[i].FR2 = filters.bank[i].FR2;
+      CANx->FA1R |= bit;
+    }
+
+  CANx->FMR &= ~CAN_FMR_FINIT;
+}
+
+void can_driver_t::set_filters( const CAN_filter_setup_t &setup)
+{
+  taskENTER_CRITICAL();
+  filters = setup;
+  program_filters();
+  taskEXIT_CRITICAL();
+}
+
 void can_driver_t::initialize(void)
 {
   if (HAL_CAN_DeInit (&CanHandle) != HAL_OK)
@@ -172,8 +235,6 @@ void can_driver_t::initialize(void)
 
   HAL_GPIO_Init (CANx_RX_GPIO_PORT, &GPIO_InitStruct);
 
-  CAN_FilterTypeDef sFilterConfig={0};
-
   /*##-1- Configure the CAN peripheral #######################################*/
   CanHandle.Instance = CANx;
 
@@ -193,19 +254,7 @@ void can_driver_t::initialize(void)
     ASSERT( 0);
 
   /*##-2- Configure the CAN Filter ###########################################*/
-  sFilterConfig.FilterBank = 0;
-  sFilterConfig.FilterMode = CAN_FILTERMODE_IDMASK;
-  sFilterConfig.FilterScale = CAN_FILTERSCALE_32BIT;
-  sFilterConfig.FilterIdHigh = 0x0000;
-  sFilterConfig.FilterIdLow = 0x0000;
-  sFilterConfig.FilterMaskIdHigh = 0x0000;
-  sFilterConfig.FilterMaskIdLow = 0x0000;
-  sFilterConfig.FilterFIFOAssignment = CAN_RX_FIFO0;
-  sFilterConfig.FilterActivation = ENABLE;
-  sFilterConfig.SlaveStartFilterBank = 14;
-
-  if (HAL_CAN_ConfigFilter (&CanHandle, &sFilterConfig) != HAL_OK)
-    ASSERT( 0);
+  program_filters();
 
   /*##-3- Start the CAN peripheral ###########################################*/
   if (HAL_CAN_Start (&CanHandle) != HAL_OK)
@@ -232,8 +281,14 @@ void can_driver_t::initialize(void)
 
   CANx->MSR = CAN_MSR_ERRI_Msk; // reset any pending error
   CANx->IER |= CAN_IT_RX_FIFO0_MSG_PENDING; // enable CANx FIFO 0 RX interrupt
+  CANx->IER |= CAN_IT_TX_MAILBOX_EMPTY; // TX completion, see CAN1_TX_IRQHandler
   CANx->IER |= CAN_IER_BOFIE | CAN_IER_LECIE | CAN_IER_EPVIE | CAN_IER_EWGIE | CAN_IER_ERRIE;
 
+  if( locked_by_error)
+    {
+      statistics.locked_ms += ( xTaskGetTickCount() - lock_time) * portTICK_PERIOD_MS;
+      locked_by_error = false;
+    }
   locked = false; // allow usage now
 }
 
@@ -242,8 +297,19 @@ void CAN_reset_timer_callback( TimerHandle_t)
   CAN_driver.initialize();
 }
 
+COMMON static CAN_send_hook_t CAN_send_hook;
+COMMON static TaskHandle_t CAN_send_hook_task;
+
+void set_CAN_send_hook( CAN_send_hook_t hook)
+{
+  CAN_send_hook_task = xTaskGetCurrentTaskHandle();
+  CAN_send_hook = hook;
+}
+
 bool CAN_send( const CANpacket &p, unsigned max_delay)
 {
+  if( CAN_send_hook && ( CAN_send_hook_task == xTaskGetCurrentTaskHandle()) && CAN_send_hook( p))
+    return true;
   return CAN_driver.send(p, max_delay);
 }
 
@@ -16,9 +16,17 @@
 #include "stm32f4xx_hal_can.h"
 
 #include "generic_CAN_driver.h"
+#include "CAN_filter_banks.h"
+#include "CAN_priority_queue.h"
+#include "CAN_bus_timing.h"
+#include "CAN_statistics.h"
+
+#define CAN_TX_QUEUE_SIZE 20
 
 #ifdef __cplusplus
 
+extern uint64_t getTime_usec(void);
+
 namespace CAN_driver_ISR // need a namespace to declare friend functions
 {
   extern "C" void CAN1_RX0_IRQHandler(void);
@@ -44,39 +52,83 @@ public:
     if( locked)
       return true; // silently ignore request, CAN not ready
 
-    /* Temporarily disable Transmit mailbox empty Interrupt */
-    CAN1->IER &= ~CAN_IT_TX_MAILBOX_EMPTY;
-    if ( send_can_packet( packet) == true) // hardware FIFO
+    while( true)
       {
-      /* Enable Transmit mailbox empty Interrupt */
-      CAN1->IER |= CAN_IT_TX_MAILBOX_EMPTY;
-      return true;
-      }
+	uint32_t time = (uint32_t)getTime_usec();
 
-    bool ret = TX_queue.send( packet, wait);
+	vTaskSuspendAll(); // the TX queue is shared by all sending tasks
+	/* Temporarily disable Transmit mailbox empty Interrupt */
+	CAN1->IER &= ~CAN_IT_TX_MAILBOX_EMPTY;
+	bool queued = TX_queue.push( packet, time);
+	if( ! queued)
+	  ++tx_waiters; // the ISR signals once per packet leaving the queue
+	if( TX_queue.get_count() > statistics.tx_queue_high_water)
+	  statistics.tx_queue_high_water = TX_queue.get_count();
+	fill_mailboxes(); // the most urgent packets go to the hardware
+	/* Enable Transmit mailbox empty Interrupt */
+	CAN1->IER |= CAN_IT_TX_MAILBOX_EMPTY;
+	xTaskResumeAll();
 
-    /* Enable Transmit mailbox empty Interrupt */
-    CAN1->IER |= CAN_IT_TX_MAILBOX_EMPTY;
-
-    return ret;
+	if( queued)
+	  return true;
+	if( ! TX_space.wait( wait)) // signalled when a full queue has been drained
+	  {
+	    // withdraw, or consume the signal given after the timeout
+	    vTaskSuspendAll();
+	    CAN1->IER &= ~CAN_IT_TX_MAILBOX_EMPTY;
+	    if( tx_waiters > 0)
+	      --tx_waiters;
+	    else
+	      TX_space.wait( NO_WAIT);
+	    CAN1->IER |= CAN_IT_TX_MAILBOX_EMPTY;
+	    xTaskResumeAll();
+	    return false;
+	  }
+      }
   }
-  bool send_can_packet( const CANpacket &msg); //!< helper function
+  bool send_can_packet( const CANpacket &msg, uint32_t time = 0); //!< helper function
+  unsigned fill_mailboxes( void); //!< TX interrupt has to be off or running, returns packets taken from the queue
   Queue <CANpacket> get_RX_Queue( void ) const
   {
     return RX_queue;
   }
   void reset(void);
+  void set_filters( const CAN_filter_setup_t &setup); //!< must run privileged
+  //! wrapping count of bits sent by this node, the share of the bus we control
+  //! received frames are not counted: the filters hide most of the foreign traffic
+  uint32_t get_tx_bits( void) const
+  {
+    return tx_bits;
+  }
+  void get_statistics( CAN_statistics_t &target) const
+  {
+    target = statistics;
+  }
 private:
+  void program_filters( void);
   Queue <CANpacket> RX_queue;
-  Queue <CANpacket> TX_queue;
+  CAN_priority_queue_t <CANpacket, CAN_TX_QUEUE_SIZE> TX_queue;
+  Semaphore TX_space; //!< counting: one signal per blocked sender
+  volatile unsigned tx_waiters; //!< senders blocked on a full queue and not yet signalled
   timer reset_timer;
   bool locked;
+  CAN_filter_setup_t filters; //!< kept to be re-applied after a reset
+  volatile uint32_t tx_bits;
+  CAN_statistics_t statistics;
+  uint32_t mailbox_time[3]; //!< usec, time the packet has been given to send()
+  TickType_t lock_time;
+  bool locked_by_error;
 };
 
 extern COMMON can_driver_t CAN_driver; //!< singleton CAN driver object
 
 void CAN_reset_timer_callback( TimerHandle_t);
 
+typedef bool (*CAN_send_hook_t)( const CANpacket &p);
+//! divert the CAN_send() packets of the calling task, 0 = off
+//! a hook returning false lets the packet pass
+void set_CAN_send_hook( CAN_send_hook_t hook);
+
 #else
 QueueHandle_t get_RX_queue( void);
 #endif // cplusplus
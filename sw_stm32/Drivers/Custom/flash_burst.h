@@ -0,0 +1,121 @@
+/***********************************************************************//**
+ * @file		flash_burst.h
+ * @brief		interrupt-chained flash word programming state
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#ifndef FLASH_BURST_H_
+#define FLASH_BURST_H_
+
+#include "stdint.h"
+
+/*!
+ Programs a block of words with one flash unlock and one task wake-up.
+ The task programs the first word, the flash ISR starts each following one
+ as soon as the HAL has released the flash handle (not from the end-of-operation
+ callback, the HAL still holds its lock there).
+ This file has no target dependencies and can be used by host tools.
+ */
+class flash_burst_t
+{
+public:
+  enum step_t
+  {
+    STEP_BUSY,		//!< no operation completed, nothing to do
+    STEP_PROGRAM,	//!< program value at dest now
+    STEP_DONE		//!< burst finished or failed: wake the task
+  };
+
+  //! prepare a burst of n_words, the caller programs the first word itself
+  //! @return false if n_words is 0
+  bool start( uint32_t *dest, const uint32_t *source, unsigned n_words)
+  {
+    if( n_words == 0)
+      return false;
+    next_dest = dest + 1;
+    next_source = source + 1;
+    remaining = n_words - 1;
+    failed = false;
+    operation_done = false;
+    return true;
+  }
+
+  //! called from the HAL end-of-operation callback
+  void end_of_operation( void)
+  {
+    operation_done = true;
+  }
+
+  //! called from the HAL error callback
+  void operation_error( void)
+  {
+    failed = true;
+    operation_done = true;
+  }
+
+  //! called from the flash ISR after the HAL interrupt handler
+  step_t step( uint32_t * &dest, uint32_t &value)
+  {
+    if( not operation_done)
+      return STEP_BUSY;
+    operation_done = false;
+
+    if( ( remaining == 0) || failed)
+      return STEP_DONE;
+
+    --remaining;
+    dest = next_dest++;
+    value = *next_source++;
+    return STEP_PROGRAM;
+  }
+
+  //! the HAL refused to start the word returned by step(): report STEP_DONE
+  void program_refused( void)
+  {
+    failed = true;
+  }
+
+  //! stop the chain, only with the flash interrupt masked
+  void abort( void)
+  {
+    remaining = 0;
+    failed = true;
+  }
+
+  //! no further words are started, e.g. before an erase
+  void clear( void)
+  {
+    remaining = 0;
+  }
+
+  bool has_failed( void) const
+  {
+    return failed;
+  }
+
+private:
+  uint32_t * volatile next_dest;
+  const uint32_t * volatile next_source;
+  volatile unsigned remaining;
+  volatile bool failed;
+  volatile bool operation_done;
+};
+
+#endif /* FLASH_BURST_H_ */
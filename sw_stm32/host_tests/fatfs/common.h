@@ -0,0 +1,2 @@
+/* host build: no separate memory region for data shared between tasks */
+#define COMMON
@@ -0,0 +1,6 @@
+/* host build of FatFs with the target configuration, f_mkfs added for RAM disk images */
+#define __STM32F4_SD_H /* no SD card driver declarations */
+#include "../../FATFS/Target/ffconf.h"
+
+#undef _USE_MKFS
+#define _USE_MKFS 1
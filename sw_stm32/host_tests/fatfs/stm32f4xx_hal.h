@@ -0,0 +1 @@
+/* empty: target header included by ffconf.h */
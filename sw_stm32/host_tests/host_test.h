@@ -0,0 +1,45 @@
+/***********************************************************************//**
+ * @file		host_test.h
+ * @brief		minimal check macros for the host unit tests
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#ifndef HOST_TEST_H_
+#define HOST_TEST_H_
+
+#include <stdio.h>
+
+static unsigned host_test_failures = 0;
+
+//! report a failed condition and keep on running
+#define CHECK( condition) \
+  do { \
+      if( ! ( condition)) \
+	{ \
+	  printf( "%s:%d: CHECK( %s) failed\n", __FILE__, __LINE__, #condition); \
+	  ++host_test_failures; \
+	} \
+  } while( 0)
+
+//! main() return value
+#define TEST_RESULT() \
+  ( host_test_failures ? printf( "%u check(s) failed\n", host_test_failures), 1 : 0)
+
+#endif /* HOST_TEST_H_ */
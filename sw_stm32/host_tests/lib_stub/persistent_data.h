@@ -0,0 +1,25 @@
+/* host build: the parts of the lib module persistent_data.h used by the tested headers */
+#ifndef PERSISTENT_DATA_H_
+#define PERSISTENT_DATA_H_
+
+#include <stdint.h>
+
+enum EEPROM_PARAMETER_ID
+{
+  SENS_TILT_ROLL, SENS_TILT_PITCH, SENS_TILT_YAW,
+  PITOT_OFFSET, PITOT_SPAN, QNH_OFFSET,
+  MAG_AUTO_CALIB, VARIO_TC, VARIO_INT_TC, WIND_TC, MEAN_WIND_TC,
+  GNSS_CONFIGURATION, ANT_BASELENGTH, ANT_SLAVE_DOWN, ANT_SLAVE_RIGHT,
+  VARIO_P_TC, HORIZON,
+  LOWEST_UNUSED_EEPROM_ID
+};
+
+typedef struct
+{
+  EEPROM_PARAMETER_ID id;
+  bool is_an_angle;
+  const char * mnemonic;
+  float default_value;
+} persistent_data_t;
+
+#endif /* PERSISTENT_DATA_H_ */
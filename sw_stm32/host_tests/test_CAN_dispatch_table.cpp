@@ -0,0 +1,199 @@
+/***********************************************************************//**
+ * @file		test_CAN_dispatch_table.cpp
+ * @brief		adding and retiring CAN distributor subscriptions
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#include "host_test.h"
+#include "CAN_dispatch_table.h"
+
+typedef struct
+{
+  uint16_t id;
+} packet_t;
+
+//! bounded queue model counting the packets it took
+class queue_t
+{
+public:
+  queue_t( unsigned depth = 100)
+  : depth( depth), received( 0)
+  {}
+  bool send( const packet_t &, unsigned)
+  {
+    if( received == depth)
+      return false;
+    ++received;
+    return true;
+  }
+  unsigned depth;
+  unsigned received;
+};
+
+typedef struct
+{
+  uint16_t ID_mask;
+  uint16_t ID_value;
+  queue_t * queue;
+} entry_t;
+
+#define SUBSCRIBERS 4
+typedef CAN_dispatch_table_t< queue_t, SUBSCRIBERS> table_t;
+
+static void send( table_t &table, uint16_t id)
+{
+  packet_t p = { id};
+  table.distribute( p);
+}
+
+static void test_exact_and_mask_rules( void)
+{
+  static table_t table;
+  queue_t exact, second, range;
+  entry_t e_exact = { 0x7ff, 0x120, &exact};
+  entry_t e_second = { 0xffff, 0x120, &second};	// same ID, wider mask: also exact
+  entry_t e_range = { 0x700, 0x100, &range};
+
+  CHECK( table.add( e_exact));
+  CHECK( table.add( e_second));
+  CHECK( table.add( e_range));
+
+  send( table, 0x120);
+  send( table, 0x121);
+  send( table, 0x220);
+  CHECK( exact.received == 1);
+  CHECK( second.received == 1);
+  CHECK( range.received == 2);
+}
+
+static void test_retire_and_recycle( void)
+{
+  static table_t table;
+  queue_t a, b, c;
+  entry_t e_a = { 0x7ff, 0x10, &a};
+  entry_t e_b = { 0x7ff, 0x10, &b};
+  entry_t e_c = { 0x7f0, 0x20, &c};
+
+  CHECK( table.add( e_a));
+  CHECK( table.add( e_b));
+  CHECK( table.add( e_c));
+
+  // chain of ID 0x10: b a
+  CHECK( table.retire( e_a));	// added first: chain end
+  CHECK( ! table.retire( e_a));	// already gone
+  send( table, 0x10);
+  CHECK( a.received == 0);
+  CHECK( b.received == 1);
+
+  entry_t other_queue = { 0x7ff, 0x10, &c};
+  CHECK( ! table.retire( other_queue)); // same rule, different subscriber
+  CHECK( table.retire( e_c));
+  send( table, 0x25);
+  CHECK( c.received == 0);
+
+  // retired slots are not reused before the reader recycled them
+  CHECK( table.state( 1) == table_t::SLOT_RETIRED);
+  CHECK( table.state( 3) == table_t::SLOT_RETIRED);
+  queue_t d, e, f;
+  entry_t e_d = { 0x7ff, 0x30, &d};
+  entry_t e_e = { 0x7ff, 0x31, &e};
+  entry_t e_f = { 0x7ff, 0x32, &f};
+  CHECK( table.add( e_d));	// slot 4
+  CHECK( ! table.add( e_e));	// full
+
+  entry_t active[ SUBSCRIBERS];
+  CHECK( table.recycle( active) == 2);
+  CHECK( active[0].queue == &b);
+  CHECK( active[1].queue == &d);
+  CHECK( table.state( 1) == table_t::SLOT_FREE);
+  CHECK( table.add( e_e));
+  CHECK( table.add( e_f));
+  CHECK( ! table.add( e_a));
+
+  send( table, 0x10);
+  send( table, 0x31);
+  send( table, 0x32);
+  CHECK( b.received == 2);
+  CHECK( e.received == 1);
+  CHECK( f.received == 1);
+}
+
+//! a slot retired while a packet is on its way keeps the chain intact for that packet
+static void test_retire_during_traversal( void)
+{
+  static table_t table;
+  queue_t a, b, c;
+  entry_t e_a = { 0x7ff, 0x40, &a};
+  entry_t e_b = { 0x7ff, 0x40, &b};
+  entry_t e_c = { 0x7ff, 0x40, &c};
+  CHECK( table.add( e_a));
+  CHECK( table.add( e_b));
+  CHECK( table.add( e_c)); // chain: c b a
+
+  CHECK( table.retire( e_b));
+  CHECK( table.retire( e_c));
+  entry_t active[ SUBSCRIBERS];
+  CHECK( table.recycle( active) == 1);
+  send( table, 0x40);
+  CHECK( a.received == 1);
+  CHECK( b.received == 0);
+  CHECK( c.received == 0);
+
+  // the freed slots are reused at the chain head
+  CHECK( table.add( e_c));
+  CHECK( table.add( e_b));
+  send( table, 0x40);
+  CHECK( a.received == 2);
+  CHECK( b.received == 1);
+  CHECK( c.received == 1);
+}
+
+static void test_drop_count( void)
+{
+  static table_t table;
+  queue_t small( 2), large;
+  entry_t e_small = { 0x7ff, 0x50, &small};
+  entry_t e_large = { 0x7ff, 0x50, &large};
+  CHECK( table.add( e_small));
+  CHECK( table.add( e_large));
+
+  for( unsigned i = 0; i < 5; ++i)
+    send( table, 0x50);
+  CHECK( table.drop_count( e_small) == 3);
+  CHECK( table.drop_count( e_large) == 0);
+  CHECK( large.received == 5); // a full queue does not block the others
+
+  // a new subscription starts at zero
+  CHECK( table.retire( e_small));
+  entry_t active[ SUBSCRIBERS];
+  table.recycle( active);
+  CHECK( table.drop_count( e_small) == 0);
+  CHECK( table.add( e_small));
+  CHECK( table.drop_count( e_small) == 0);
+}
+
+int main( void)
+{
+  test_exact_and_mask_rules();
+  test_retire_and_recycle();
+  test_retire_during_traversal();
+  test_drop_count();
+  return TEST_RESULT();
+}
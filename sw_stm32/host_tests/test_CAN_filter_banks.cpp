@@ -0,0 +1,194 @@
+/***********************************************************************//**
+ * @file		test_CAN_filter_banks.cpp
+ * @brief		packing of CAN subscriptions into bxCAN filter banks
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#include "host_test.h"
+#include "CAN_filter_banks.h"
+
+typedef struct
+{
+  uint16_t ID_value;
+  uint16_t ID_mask;
+} subscription_t;
+
+enum { FRAME_DATA = 0, FRAME_RTR = 0x10, FRAME_EXTENDED = 0x08};
+
+//! software model of one 16 bit filter bank: does the frame pass?
+//! an extended frame is presented with its top 11 ID bits, EXTID[17:15] zero
+static bool bank_accepts( const CAN_filter_bank_t &bank, uint16_t id, unsigned frame_type = FRAME_DATA)
+{
+  uint32_t frame = CAN_filter_field( id) | frame_type;
+  uint32_t half[4] = { bank.FR1 & 0xffff, bank.FR1 >> 16, bank.FR2 & 0xffff, bank.FR2 >> 16};
+  if( bank.list_mode)
+    return frame == half[0] || frame == half[1] || frame == half[2] || frame == half[3];
+  return (( frame & half[1]) == ( half[0] & half[1])) || (( frame & half[3]) == ( half[2] & half[3]));
+}
+
+static bool setup_accepts( const CAN_filter_setup_t &setup, uint16_t id, unsigned frame_type = FRAME_DATA)
+{
+  for( unsigned i = 0; i < setup.bank_count; ++i)
+    if( bank_accepts( setup.bank[i], id, frame_type))
+      return true;
+  return false;
+}
+
+//! the hardware must pass every frame a subscription wants
+static void check_no_frame_lost( const subscription_t * entry, unsigned entries, const CAN_filter_setup_t &setup)
+{
+  for( unsigned id = 0; id < 0x800; ++id)
+    for( unsigned i = 0; i < entries; ++i)
+      if( ( id & entry[i].ID_mask) == entry[i].ID_value)
+	CHECK( setup_accepts( setup, id));
+}
+
+static void test_packing( void)
+{
+  const subscription_t entry[] =
+    {
+      { 0x40f, 0x402},	// can never match: skipped
+      { 0x070, 0xfff},	// exact
+      { 0x070, 0xfff},	// duplicate
+      { 0x120, 0x7ff},	// exact
+      { 0x1000, 0xff},	// out of range: skipped
+      { 0x100, 0x700},	// range rule
+    };
+  const unsigned entries = sizeof( entry) / sizeof( entry[0]);
+
+  CAN_filter_setup_t setup;
+  CHECK( make_CAN_filter_setup( entry, entries, setup));
+  CHECK( setup.bank_count == 2);
+  CHECK( setup.bank[0].list_mode);
+  CHECK( setup.bank[0].FR1 == 0x24000e00);
+  CHECK( setup.bank[0].FR2 == 0x24002400);
+  CHECK( not setup.bank[1].list_mode);
+  CHECK( setup.bank[1].FR1 == 0xe0182000);
+  CHECK( setup.bank[1].FR2 == 0xe0182000);
+
+  check_no_frame_lost( entry, entries, setup);
+  CHECK( not setup_accepts( setup, 0x071));
+  CHECK( not setup_accepts( setup, 0x200));
+  CHECK( setup_accepts( setup, 0x1ff));
+}
+
+//! 14 banks hold 56 exact IDs, one more needs the accept-all fallback
+static void test_capacity( void)
+{
+  subscription_t entry[ CAN_FILTER_BANKS * 4 + 1];
+  for( unsigned i = 0; i < CAN_FILTER_BANKS * 4 + 1; ++i)
+    {
+      entry[i].ID_value = 0x300 + i;
+      entry[i].ID_mask = 0x7ff;
+    }
+
+  CAN_filter_setup_t setup;
+  CHECK( make_CAN_filter_setup( entry, CAN_FILTER_BANKS * 4, setup));
+  CHECK( setup.bank_count == CAN_FILTER_BANKS);
+  check_no_frame_lost( entry, CAN_FILTER_BANKS * 4, setup);
+  CHECK( not setup_accepts( setup, 0x300 + CAN_FILTER_BANKS * 4));
+
+  CHECK( not make_CAN_filter_setup( entry, CAN_FILTER_BANKS * 4 + 1, setup));
+  CHECK( setup.bank_count == 1);
+  for( unsigned id = 0; id < 0x800; ++id)
+    CHECK( setup_accepts( setup, id));
+
+  // exact IDs and rules share the banks: 6 * 4 IDs + 16 rules = 14 banks
+  subscription_t mixed[ 24 + 17];
+  for( unsigned i = 0; i < 24; ++i)
+    {
+      mixed[i].ID_value = 0x300 + i;
+      mixed[i].ID_mask = 0x7ff;
+    }
+  for( unsigned i = 0; i < 17; ++i)
+    {
+      mixed[ 24 + i].ID_value = ( i + 1) << 4;
+      mixed[ 24 + i].ID_mask = 0x7f0;
+    }
+  CHECK( make_CAN_filter_setup( mixed, 24 + 16, setup));
+  CHECK( setup.bank_count == CAN_FILTER_BANKS);
+  check_no_frame_lost( mixed, 24 + 16, setup);
+  CHECK( not make_CAN_filter_setup( mixed, 24 + 17, setup));
+}
+
+//! only standard data frames pass, with subscriptions as well as with the accept-all fallback
+static void test_frame_types( void)
+{
+  const subscription_t entry[] =
+    {
+      { 0x070, 0x7ff},
+      { 0x100, 0x700},
+    };
+  CAN_filter_setup_t setup;
+  CHECK( make_CAN_filter_setup( entry, 2, setup));
+  CHECK( setup_accepts( setup, 0x070));
+  CHECK( not setup_accepts( setup, 0x070, FRAME_RTR));
+  CHECK( not setup_accepts( setup, 0x070, FRAME_EXTENDED));
+  CHECK( not setup_accepts( setup, 0x123, FRAME_RTR));
+  CHECK( not setup_accepts( setup, 0x123, FRAME_EXTENDED | FRAME_RTR));
+
+  set_CAN_filter_accept_all( setup);
+  for( unsigned id = 0; id < 0x800; ++id)
+    {
+      CHECK( setup_accepts( setup, id));
+      CHECK( not setup_accepts( setup, id, FRAME_RTR));
+      CHECK( not setup_accepts( setup, id, FRAME_EXTENDED));
+    }
+}
+
+/*!
+ RX interrupt rate on a fully loaded bus with evenly spread IDs,
+ subscriptions as made by the CAN listener and the CAN distributor.
+ */
+static void test_interrupt_rate( void)
+{
+  CHECK( CAN_max_frame_rate( 8) == 7407);
+  CHECK( CAN_max_frame_rate( 0) == 18181);
+
+  const subscription_t entry[] =
+    {
+      { 0x402, 0x40f},	// set system wide config item
+      { 0x070, 0xfff},	// external magnetometer
+      { 0x019, 0xffff},	// CAN distributor test subscription
+    };
+  CAN_filter_setup_t setup;
+  CHECK( make_CAN_filter_setup( entry, 3, setup));
+  check_no_frame_lost( entry, 3, setup);
+
+  unsigned accepted = 0;
+  for( unsigned id = 0; id < 0x800; ++id)
+    if( setup_accepts( setup, id))
+      ++accepted;
+  CHECK( accepted == 66);
+
+  unsigned filtered_rate = CAN_max_frame_rate( 8) * accepted / 0x800;
+  printf( "RX interrupts on a loaded bus: %u/s without filters, %u/s with %u banks\n",
+      CAN_max_frame_rate( 8), filtered_rate, setup.bank_count);
+  CHECK( filtered_rate * 20 < CAN_max_frame_rate( 8));
+}
+
+int main( void)
+{
+  test_packing();
+  test_capacity();
+  test_frame_types();
+  test_interrupt_rate();
+  return TEST_RESULT();
+}
@@ -0,0 +1,249 @@
+/***********************************************************************//**
+ * @file		test_CAN_output_scheduler.cpp
+ * @brief		spreading the CAN output frames over the sub-ticks
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#include "host_test.h"
+#include "CAN_output_scheduler.h"
+
+typedef struct
+{
+  uint16_t id;
+  uint8_t dlc;
+  uint32_t data;
+} packet_t;
+
+#define CLASSES 32
+typedef CAN_output_scheduler_t< packet_t, CLASSES> scheduler_t;
+
+#define MAX_SENT 400
+static packet_t sent_packet[ MAX_SENT];
+static unsigned sent_count;
+
+static void record( const packet_t &p)
+{
+  if( sent_count < MAX_SENT)
+    sent_packet[ sent_count] = p;
+  ++sent_count;
+}
+
+static unsigned times_sent( uint16_t id)
+{
+  unsigned count = 0;
+  for( unsigned i = 0; i < sent_count && i < MAX_SENT; ++i)
+    count += ( sent_packet[i].id == id);
+  return count;
+}
+
+//! one output cycle: IDs first_id ... first_id + frames - 1 captured, all sub-ticks released
+static void run_cycle( scheduler_t &scheduler, uint16_t first_id, unsigned frames, uint32_t data = 0)
+{
+  scheduler.start_cycle();
+  for( unsigned i = 0; i < frames; ++i)
+    {
+      packet_t p = { (uint16_t)( first_id + i), 8, data};
+      CHECK( scheduler.capture( p));
+    }
+  for( unsigned subtick = 0; subtick < CAN_OUTPUT_SUBTICKS; ++subtick)
+    scheduler.release( subtick, record);
+}
+
+static void test_spreading( void)
+{
+  static scheduler_t scheduler;
+  sent_count = 0;
+  scheduler.start_cycle();
+  for( unsigned i = 0; i < 20; ++i)
+    {
+      packet_t p = { (uint16_t)( 0x100 + i), 8, i};
+      CHECK( scheduler.capture( p));
+    }
+  CHECK( scheduler.get_class_count() == 20);
+  CHECK( sent_count == 0); // nothing leaves at capture time
+
+  unsigned max_per_subtick = 0;
+  for( unsigned subtick = 0; subtick < CAN_OUTPUT_SUBTICKS; ++subtick)
+    {
+      CHECK( scheduler.get_subtick_bits( subtick) == 2 * CAN_frame_bits( 8));
+      unsigned sent = scheduler.release( subtick, record);
+      if( sent > max_per_subtick)
+	max_per_subtick = sent;
+    }
+  CHECK( sent_count == 20);
+  CHECK( max_per_subtick == 2);
+  for( unsigned i = 0; i < 20; ++i)
+    CHECK( times_sent( 0x100 + i) == 1);
+
+  // a released sub-tick does not send again
+  CHECK( scheduler.release( CAN_OUTPUT_SUBTICKS - 1, record) == 0);
+
+  printf( "20 frames: at most %u per 10 ms sub-tick instead of a burst of 20\n", max_per_subtick);
+}
+
+static void test_repeated_id_and_fresh_data( void)
+{
+  static scheduler_t scheduler;
+  sent_count = 0;
+
+  // the same ID twice per cycle makes two classes with their own phases
+  scheduler.start_cycle();
+  packet_t first = { 0x200, 8, 1};
+  packet_t second = { 0x200, 4, 2};
+  CHECK( scheduler.capture( first));
+  CHECK( scheduler.capture( second));
+  CHECK( scheduler.get_class_count() == 2);
+  CHECK( scheduler.get_subtick_bits( 0) == CAN_frame_bits( 8));
+  CHECK( scheduler.get_subtick_bits( 1) == CAN_frame_bits( 4));
+  for( unsigned subtick = 0; subtick < CAN_OUTPUT_SUBTICKS; ++subtick)
+    scheduler.release( subtick, record);
+  CHECK( sent_count == 2);
+  CHECK( sent_packet[0].data == 1);
+  CHECK( sent_packet[1].data == 2);
+
+  // the next cycle reuses the classes and sends the latest data
+  sent_count = 0;
+  run_cycle( scheduler, 0x200, 1, 7);
+  CHECK( scheduler.get_class_count() == 2);
+  CHECK( sent_count == 1);
+  CHECK( sent_packet[0].data == 7);
+}
+
+static void test_missed_subticks( void)
+{
+  static scheduler_t scheduler;
+  sent_count = 0;
+  run_cycle( scheduler, 0x300, 10); // one frame per sub-tick, phase = position
+  CHECK( sent_count == 10);
+
+  // the task missed sub-ticks 1 ... 5: the late release catches up in order
+  sent_count = 0;
+  scheduler.start_cycle();
+  for( unsigned i = 0; i < 10; ++i)
+    {
+      packet_t p = { (uint16_t)( 0x300 + i), 8, 0};
+      scheduler.capture( p);
+    }
+  CHECK( scheduler.release( 0, record) == 1);
+  CHECK( scheduler.release( 6, record) == 6);
+  CHECK( sent_packet[1].id == 0x301);
+  CHECK( sent_packet[6].id == 0x306);
+
+  // the cycle ends early: the leftovers go out before the next one starts
+  CHECK( scheduler.release( CAN_OUTPUT_SUBTICKS - 1, record) == 3);
+  CHECK( sent_count == 10);
+  for( unsigned i = 0; i < 10; ++i)
+    CHECK( times_sent( 0x300 + i) == 1);
+
+  // a frame not produced in this cycle is not repeated
+  sent_count = 0;
+  scheduler.start_cycle();
+  packet_t p = { 0x305, 8, 0};
+  scheduler.capture( p);
+  scheduler.release( CAN_OUTPUT_SUBTICKS - 1, record);
+  CHECK( sent_count == 1);
+  CHECK( sent_packet[0].id == 0x305);
+}
+
+static void test_decimation( void)
+{
+  static scheduler_t scheduler;
+  sent_count = 0;
+  run_cycle( scheduler, 0x400, 4);
+
+  // above the budget: the highest ID is thinned out first
+  scheduler.adapt( 60, 50);
+  sent_count = 0;
+  for( unsigned cycle = 0; cycle < 8; ++cycle)
+    run_cycle( scheduler, 0x400, 4);
+  CHECK( times_sent( 0x400) == 8);
+  CHECK( times_sent( 0x402) == 8);
+  CHECK( times_sent( 0x403) == 4);
+
+  // one step per call up to MAX_DECIMATION, then the next lower ID
+  scheduler.adapt( 60, 50);
+  scheduler.adapt( 60, 50);
+  scheduler.adapt( 60, 50);
+  sent_count = 0;
+  for( unsigned cycle = 0; cycle < 16; ++cycle)
+    run_cycle( scheduler, 0x400, 4);
+  CHECK( times_sent( 0x403) == 2);
+  CHECK( times_sent( 0x402) == 8);
+  CHECK( times_sent( 0x401) == 16);
+
+  // between half the budget and the budget nothing changes
+  scheduler.adapt( 40, 50);
+  sent_count = 0;
+  for( unsigned cycle = 0; cycle < 16; ++cycle)
+    run_cycle( scheduler, 0x400, 4);
+  CHECK( times_sent( 0x403) == 2);
+  CHECK( times_sent( 0x402) == 8);
+
+  // well below the budget the lowest decimated ID is restored first, at once
+  scheduler.adapt( 10, 50);
+  sent_count = 0;
+  run_cycle( scheduler, 0x400, 4);
+  CHECK( times_sent( 0x402) == 1);
+  for( unsigned cycle = 1; cycle < 16; ++cycle)
+    run_cycle( scheduler, 0x400, 4);
+  CHECK( times_sent( 0x402) == 16);
+  CHECK( times_sent( 0x403) == 2);
+
+  for( unsigned step = 0; step < 3; ++step)
+    scheduler.adapt( 10, 50);
+  sent_count = 0;
+  for( unsigned cycle = 0; cycle < 8; ++cycle)
+    run_cycle( scheduler, 0x400, 4);
+  CHECK( sent_count == 32);
+
+  // all classes at MAX_DECIMATION: each one sent every 8th cycle
+  for( unsigned step = 0; step < 4 * 3; ++step)
+    scheduler.adapt( 100, 50);
+  sent_count = 0;
+  for( unsigned cycle = 0; cycle < 8; ++cycle)
+    run_cycle( scheduler, 0x400, 4);
+  CHECK( sent_count == 4);
+  printf( "load decimation: %u of 32 frames left at the maximum\n", sent_count);
+}
+
+static void test_class_overflow( void)
+{
+  static scheduler_t scheduler;
+  scheduler.start_cycle();
+  for( unsigned i = 0; i < CLASSES; ++i)
+    {
+      packet_t p = { (uint16_t)( 0x500 + i), 8, 0};
+      CHECK( scheduler.capture( p));
+    }
+  packet_t extra = { 0x600, 8, 0};
+  CHECK( ! scheduler.capture( extra)); // to be sent directly by the caller
+  packet_t again = { 0x500, 8, 0};
+  CHECK( ! scheduler.capture( again)); // second occurrence would be a new class
+}
+
+int main( void)
+{
+  test_spreading();
+  test_repeated_id_and_fresh_data();
+  test_missed_subticks();
+  test_decimation();
+  test_class_overflow();
+  return TEST_RESULT();
+}
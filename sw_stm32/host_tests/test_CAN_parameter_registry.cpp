@@ -0,0 +1,121 @@
+/***********************************************************************//**
+ * @file		test_CAN_parameter_registry.cpp
+ * @brief		CAN parameter registry against a PERSISTENT_DATA table
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#include "host_test.h"
+#include "CAN_parameter_registry.h"
+
+//! PERSISTENT_DATA shape, mnemonics as in configuration/larus_sensor_config.ini
+static const persistent_data_t persistent_data[] =
+  {
+    { SENS_TILT_ROLL,	  true,	 "SensTilt_Roll",	0.0f},
+    { SENS_TILT_PITCH,	  true,	 "SensTilt_Pitch",	0.0f},
+    { SENS_TILT_YAW,	  true,	 "SensTilt_Yaw",	0.0f},
+    { PITOT_OFFSET,	  false, "Pitot_Offset",	0.0f},
+    { PITOT_SPAN,	  false, "Pitot_Span",		1.0f},
+    { QNH_OFFSET,	  false, "QNH-delta",		0.0f},
+    { MAG_AUTO_CALIB,	  false, "Mag_Auto_Calib",	1.0f},
+    { VARIO_TC,		  false, "Vario_TC",		2.0f},
+    { VARIO_INT_TC,	  false, "Vario_Int_TC",	30.0f},
+    { WIND_TC,		  false, "Wind_TC",		5.0f},
+    { MEAN_WIND_TC,	  false, "Mean_Wind_TC",	30.0f},
+    { GNSS_CONFIGURATION, false, "GNSS_CONFIG",		1.0f},
+    { ANT_BASELENGTH,	  false, "ANT_BASELEN",		1.0f},
+    { ANT_SLAVE_DOWN,	  false, "ANT_SLAVE_DOWN",	0.0f},
+    { ANT_SLAVE_RIGHT,	  false, "ANT_SLAVE_RIGHT",	0.0f},
+    { VARIO_P_TC,	  false, "Vario_P_TC",		0.5f},
+    { HORIZON,		  false, "Horizon_active",	1.0f}
+  };
+
+enum { ENTRIES = sizeof( persistent_data) / sizeof( persistent_data_t)};
+
+//! the CAN index is the offset from PARAMETER_OFFSET, everything else is rejected
+static void test_lookup( void)
+{
+  CHECK( find_CAN_parameter( PARAMETER_OFFSET - 1) == 0);
+  CHECK( find_CAN_parameter( PARAMETER_OFFSET + CAN_PARAMETER_COUNT) == 0);
+  CHECK( find_CAN_parameter( 0) == 0);
+  CHECK( find_CAN_parameter( 0xffff) == 0);
+  for( unsigned index = 0; index < CAN_PARAMETER_COUNT; ++index)
+    CHECK( find_CAN_parameter( PARAMETER_OFFSET + index) == CAN_PARAMETERS + index);
+
+  // published CAN indices, never reordered
+  CHECK( find_CAN_parameter( PARAMETER_OFFSET + 0)->id == SENS_TILT_ROLL);
+  CHECK( find_CAN_parameter( PARAMETER_OFFSET + 3)->id == PITOT_OFFSET);
+  CHECK( find_CAN_parameter( PARAMETER_OFFSET + 16)->id == HORIZON);
+}
+
+//! the change classes the communicator reacts on
+static void test_change_classes( void)
+{
+  unsigned all = 0;
+  for( unsigned index = 0; index < CAN_PARAMETER_COUNT; ++index)
+    all |= CAN_PARAMETERS[index].change_class;
+  CHECK( all == ( CHANGE_TIME_CONSTANT | CHANGE_GNSS | CHANGE_PRESSURE | CHANGE_HORIZON));
+
+  for( unsigned index = 0; index < CAN_PARAMETER_COUNT; ++index)
+    {
+      // at most one class per parameter
+      unsigned change_class = CAN_PARAMETERS[index].change_class;
+      CHECK( ( change_class & ( change_class - 1)) == 0);
+
+      // sensor tilt angles only take effect after the calibration commands
+      for( unsigned i = 0; i < ENTRIES; ++i)
+	if( persistent_data[i].id == CAN_PARAMETERS[index].id && persistent_data[i].is_an_angle)
+	  CHECK( change_class == CHANGE_NONE);
+    }
+}
+
+//! the boot check of the CAN listener
+static void test_persistent_data_agreement( void)
+{
+  CHECK( CAN_parameter_mismatch( persistent_data, ENTRIES) == CAN_PARAMETER_COUNT);
+
+  // more entries in PERSISTENT_DATA than in the registry are fine
+  persistent_data_t extended[ ENTRIES + 1];
+  for( unsigned i = 0; i < ENTRIES; ++i)
+    extended[i] = persistent_data[i];
+  extended[ ENTRIES] = { LOWEST_UNUSED_EEPROM_ID, false, "Other", 0.0f};
+  CHECK( CAN_parameter_mismatch( extended, ENTRIES + 1) == CAN_PARAMETER_COUNT);
+
+  // a registry parameter missing in PERSISTENT_DATA
+  CHECK( CAN_parameter_mismatch( persistent_data + 1, ENTRIES - 1) == 0);
+  CHECK( CAN_parameter_mismatch( persistent_data, ENTRIES - 1) == 16);
+
+  // an ID twice: the mnemonic and default would be ambiguous
+  persistent_data_t doubled[ ENTRIES];
+  for( unsigned i = 0; i < ENTRIES; ++i)
+    doubled[i] = persistent_data[i];
+  doubled[ 10].id = VARIO_TC;
+  unsigned mismatch = CAN_parameter_mismatch( doubled, ENTRIES);
+  CHECK( CAN_PARAMETERS[ mismatch].id == VARIO_TC);
+
+  CHECK( CAN_parameter_mismatch( persistent_data, 0) == 0);
+}
+
+int main( void)
+{
+  test_lookup();
+  test_change_classes();
+  test_persistent_data_agreement();
+  return TEST_RESULT();
+}
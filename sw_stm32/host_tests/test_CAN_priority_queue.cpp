@@ -0,0 +1,121 @@
+/***********************************************************************//**
+ * @file		test_CAN_priority_queue.cpp
+ * @brief		ordering of the CAN transmit priority queue
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#include "host_test.h"
+#include "CAN_priority_queue.h"
+
+typedef struct
+{
+  uint16_t id;
+  uint16_t tag; //!< order of arrival
+} packet_t;
+
+enum { SIZE = 20};
+
+static void test_ordering( void)
+{
+  CAN_priority_queue_t < packet_t, SIZE> queue;
+  packet_t packet;
+  CHECK( queue.is_empty());
+  CHECK( not queue.pop( packet));
+
+  static const uint16_t id[ SIZE] =
+    { 0x120, 0x40f, 0x120, 0x070, 0x7ff, 0x120, 0x100, 0x070, 0x3ff, 0x500,
+      0x120, 0x001, 0x7ff, 0x100, 0x120, 0x070, 0x200, 0x001, 0x600, 0x120 };
+  for( unsigned i = 0; i < SIZE; ++i)
+    {
+      packet.id = id[i];
+      packet.tag = i;
+      CHECK( queue.push( packet, 1000 + i));
+    }
+  CHECK( queue.is_full());
+  CHECK( queue.get_count() == SIZE);
+  CHECK( not queue.push( packet));
+
+  packet_t previous = { 0, 0};
+  for( unsigned i = 0; i < SIZE; ++i)
+    {
+      uint32_t time;
+      CHECK( queue.pop( packet, time));
+      CHECK( time == 1000u + packet.tag);
+      if( i > 0)
+	{
+	  CHECK( packet.id >= previous.id); // lowest ID first
+	  if( packet.id == previous.id)
+	    CHECK( packet.tag > previous.tag); // same ID: first in, first out
+	}
+      previous = packet;
+    }
+  CHECK( queue.is_empty());
+}
+
+//! arrival order survives the wrap-around of the 16 bit sequence number
+static void test_sequence_wrap( void)
+{
+  CAN_priority_queue_t < packet_t, SIZE> queue;
+  packet_t packet;
+  unsigned tag = 0, expected = 0;
+  for( unsigned round = 0; round < 70000 / 5; ++round)
+    {
+      for( unsigned k = 0; k < 5; ++k)
+	{
+	  packet.id = 0x123;
+	  packet.tag = tag++;
+	  CHECK( queue.push( packet));
+	}
+      for( unsigned k = 0; k < 5; ++k)
+	{
+	  CHECK( queue.pop( packet));
+	  CHECK( packet.tag == (uint16_t)expected);
+	  ++expected;
+	}
+    }
+}
+
+//! interleaved push and pop as seen by the TX interrupt
+static void test_interleaved( void)
+{
+  CAN_priority_queue_t < packet_t, SIZE> queue;
+  packet_t packet;
+  packet.id = 0x300; packet.tag = 0;
+  queue.push( packet);
+  packet.id = 0x200; packet.tag = 1;
+  queue.push( packet);
+  CHECK( queue.pop( packet) && packet.id == 0x200);
+  packet.id = 0x100; packet.tag = 2;
+  queue.push( packet);
+  packet.id = 0x300; packet.tag = 3;
+  queue.push( packet);
+  CHECK( queue.pop( packet) && packet.id == 0x100);
+  CHECK( queue.pop( packet) && packet.id == 0x300 && packet.tag == 0);
+  CHECK( queue.pop( packet) && packet.id == 0x300 && packet.tag == 3);
+  CHECK( queue.is_empty());
+}
+
+int main( void)
+{
+  test_ordering();
+  test_sequence_wrap();
+  test_interleaved();
+  return TEST_RESULT();
+}
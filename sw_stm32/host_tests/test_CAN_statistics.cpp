@@ -0,0 +1,284 @@
+/***********************************************************************//**
+ * @file		test_CAN_statistics.cpp
+ * @brief		CAN statistics accounting of the interrupts on a bxCAN model
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#include "host_test.h"
+#include "CAN_mailbox_accounting.h"
+
+typedef struct
+{
+  uint16_t id;
+  uint8_t dlc;
+  uint32_t data_w[2];
+} packet_t;
+
+class bxCAN_model_t;
+
+//! RF0R: FMP0 fill level, FOVR0 write 1 to clear, RFOM0 releases the output mailbox
+class RF0R_model_t
+{
+public:
+  operator uint32_t( void) const;
+  RF0R_model_t & operator |= ( uint32_t bits);
+  bxCAN_model_t * can;
+  uint32_t overrun;
+};
+
+//! TSR: RQCPx write 1 to clear, TXOKx cleared with them
+class TSR_model_t
+{
+public:
+  operator uint32_t( void) const
+  {
+    return value;
+  }
+  TSR_model_t & operator = ( uint32_t bits)
+  {
+    for( unsigned mailbox = 0; mailbox < 3; ++mailbox)
+      if( bits & ( CAN_TX_REQUEST_COMPLETED << ( 8 * mailbox)))
+	value &= ~( ( CAN_TX_REQUEST_COMPLETED | CAN_TX_OK) << ( 8 * mailbox));
+    return *this;
+  }
+  uint32_t value;
+};
+
+typedef struct
+{
+  uint32_t RIR;
+  uint32_t RDTR;
+  uint32_t RDLR;
+  uint32_t RDHR;
+} FIFO_mailbox_t;
+
+typedef struct
+{
+  uint32_t TIR;
+  uint32_t TDTR;
+} TX_mailbox_t;
+
+//! three level RX FIFO 0 and the TX mailboxes, non-locked mode: an overrun replaces the newest frame
+class bxCAN_model_t
+{
+public:
+  bxCAN_model_t( void)
+  : fill( 0)
+  {
+    RF0R.can = this;
+    RF0R.overrun = 0;
+    TSR.value = 0;
+  }
+
+  void frame_arrives( uint16_t id, uint8_t dlc = 8)
+  {
+    if( fill == 3)
+      {
+	RF0R.overrun = CAN_RX_FIFO_OVERRUN;
+	fifo[2] = make_frame( id, dlc);
+      }
+    else
+      fifo[ fill++] = make_frame( id, dlc);
+    sFIFOMailBox[0] = fifo[0];
+  }
+
+  void release( void)
+  {
+    if( fill == 0)
+      return;
+    --fill;
+    for( unsigned i = 0; i < fill; ++i)
+      fifo[i] = fifo[i + 1];
+    sFIFOMailBox[0] = fifo[0];
+  }
+
+  void transmitted( unsigned mailbox, uint16_t id, uint8_t dlc, bool ok)
+  {
+    sTxMailBox[mailbox].TIR = (uint32_t)id << 21;
+    sTxMailBox[mailbox].TDTR = dlc;
+    TSR.value |= ( CAN_TX_REQUEST_COMPLETED | ( ok ? CAN_TX_OK : 0)) << ( 8 * mailbox);
+  }
+
+  FIFO_mailbox_t sFIFOMailBox[1];
+  TX_mailbox_t sTxMailBox[3];
+  RF0R_model_t RF0R;
+  TSR_model_t TSR;
+  unsigned fill;
+
+private:
+  static FIFO_mailbox_t make_frame( uint16_t id, uint8_t dlc)
+  {
+    FIFO_mailbox_t frame = { (uint32_t)id << 21, dlc, id, 0};
+    return frame;
+  }
+  FIFO_mailbox_t fifo[3];
+};
+
+RF0R_model_t::operator uint32_t( void) const
+{
+  return can->fill | overrun;
+}
+
+RF0R_model_t & RF0R_model_t::operator |= ( uint32_t bits)
+{
+  bits |= *this; // the read part of the read-modify-write
+  if( bits & CAN_RX_FIFO_OVERRUN)
+    overrun = 0;
+  if( bits & CAN_RX_FIFO_RELEASE)
+    can->release();
+  return *this;
+}
+
+//! bounded RX queue model
+class queue_t
+{
+public:
+  queue_t( unsigned depth)
+  : depth( depth), count( 0)
+  {}
+  bool send_from_ISR( const packet_t &p) const
+  {
+    if( count == depth)
+      return false;
+    last = p;
+    ++count;
+    return true;
+  }
+  unsigned depth;
+  mutable unsigned count;
+  mutable packet_t last;
+};
+
+//! the RX interrupt fires as long as FIFO 0 is not empty
+static void run_RX_interrupt( bxCAN_model_t &can, const queue_t &queue, CAN_statistics_t &statistics)
+{
+  while( can.fill != 0)
+    receive_CAN_FIFO0 <packet_t> ( can, queue, statistics);
+}
+
+static void test_rx_classes( void)
+{
+  bxCAN_model_t can;
+  queue_t queue( 100);
+  CAN_statistics_t statistics = {};
+
+  const uint16_t id[] = { 0x010, 0x120, 0x121, 0x402, 0x7ff, 0x403, 0x404};
+  for( unsigned i = 0; i < sizeof( id) / sizeof( id[0]); ++i)
+    {
+      can.frame_arrives( id[i], 3);
+      run_RX_interrupt( can, queue, statistics);
+    }
+  CHECK( statistics.rx_frames[0] == 1);
+  CHECK( statistics.rx_frames[1] == 2);
+  CHECK( statistics.rx_frames[4] == 3);
+  CHECK( statistics.rx_frames[7] == 1);
+  CHECK( statistics.rx_fifo_overruns == 0);
+  CHECK( statistics.rx_queue_overruns == 0);
+  CHECK( queue.count == 7);
+  CHECK( queue.last.id == 0x404);
+  CHECK( queue.last.dlc == 3);
+  CHECK( queue.last.data_w[0] == 0x404);
+}
+
+static void test_rx_fifo_overrun( void)
+{
+  bxCAN_model_t can;
+  queue_t queue( 100);
+  CAN_statistics_t statistics = {};
+
+  // interrupt latency: five frames arrive before the ISR runs, two get lost in the hardware
+  for( unsigned i = 0; i < 5; ++i)
+    can.frame_arrives( 0x200 + i);
+  CHECK( can.RF0R & CAN_RX_FIFO_OVERRUN);
+  run_RX_interrupt( can, queue, statistics);
+  CHECK( statistics.rx_frames[2] == 3);
+  CHECK( statistics.rx_fifo_overruns == 1); // one event, the flag was cleared by the first release
+  CHECK( ! ( can.RF0R & CAN_RX_FIFO_OVERRUN));
+  CHECK( queue.last.id == 0x204);
+
+  // the next overrun is counted again
+  for( unsigned i = 0; i < 4; ++i)
+    can.frame_arrives( 0x300);
+  run_RX_interrupt( can, queue, statistics);
+  CHECK( statistics.rx_fifo_overruns == 2);
+  CHECK( statistics.rx_frames[3] == 3);
+}
+
+static void test_rx_queue_overrun( void)
+{
+  bxCAN_model_t can;
+  queue_t queue( 2);
+  CAN_statistics_t statistics = {};
+
+  for( unsigned i = 0; i < 5; ++i)
+    {
+      can.frame_arrives( 0x100);
+      run_RX_interrupt( can, queue, statistics);
+    }
+  CHECK( statistics.rx_frames[1] == 5); // accepted by the filters, lost behind them
+  CHECK( statistics.rx_queue_overruns == 3);
+  CHECK( statistics.rx_fifo_overruns == 0);
+  CHECK( can.fill == 0); // a full queue does not stall the FIFO
+}
+
+static void test_tx_completions( void)
+{
+  bxCAN_model_t can;
+  CAN_statistics_t statistics = {};
+  uint32_t mailbox_time[3] = { 1000, 1100, 1200};
+
+  // mailboxes 0 and 2 sent, mailbox 1 aborted
+  can.transmitted( 0, 0x120, 8, true);
+  can.transmitted( 1, 0x130, 8, false);
+  can.transmitted( 2, 0x500, 0, true);
+  uint32_t bits = complete_CAN_mailboxes( can, statistics, mailbox_time, 1500);
+  CHECK( bits == CAN_frame_bits( 8) + CAN_frame_bits( 0));
+  CHECK( statistics.tx_frames[1] == 1);
+  CHECK( statistics.tx_frames[5] == 1);
+  CHECK( statistics.tx_latency.get_total() == 2);
+  CHECK( statistics.max_tx_latency_usec == 500);
+  CHECK( can.TSR == 0); // all completions acknowledged, the interrupt can not repeat
+
+  // nothing completed: nothing counted twice
+  CHECK( complete_CAN_mailboxes( can, statistics, mailbox_time, 1600) == 0);
+  CHECK( statistics.tx_frames[1] == 1);
+
+  // one completion per interrupt over a full TX queue
+  uint32_t total = 0;
+  for( unsigned i = 0; i < 20; ++i)
+    {
+      can.transmitted( i % 3, 0x100 + i, 8, true);
+      mailbox_time[ i % 3] = 2000 + 100 * i;
+      total += complete_CAN_mailboxes( can, statistics, mailbox_time, 2000 + 100 * i + 250);
+    }
+  CHECK( total == 20 * CAN_frame_bits( 8));
+  CHECK( statistics.tx_frames[1] == 21);
+  CHECK( statistics.tx_latency.get_total() == 22);
+  CHECK( statistics.max_tx_latency_usec == 500);
+}
+
+int main( void)
+{
+  test_rx_classes();
+  test_rx_fifo_overrun();
+  test_rx_queue_overrun();
+  test_tx_completions();
+  return TEST_RESULT();
+}
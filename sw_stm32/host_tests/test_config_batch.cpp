@@ -0,0 +1,202 @@
+/***********************************************************************//**
+ * @file		test_config_batch.cpp
+ * @brief		configuration batch: staging, timeout and coalesced change classes
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#include "host_test.h"
+#include "config_batch.h"
+
+//! change classes as in CAN_parameter_registry.h
+enum
+{
+  CHANGE_NONE		= 0,
+  CHANGE_TIME_CONSTANT 	= 1,
+  CHANGE_GNSS 		= 2,
+  CHANGE_PRESSURE 	= 4,
+  CHANGE_HORIZON 	= 8
+};
+
+enum { PARAMETERS = 17, TIMEOUT = 2000};
+
+//! registry shape: tilt, pressure, time constants, GNSS antenna, horizon
+static const unsigned change_class[ PARAMETERS] =
+  {
+    CHANGE_NONE, CHANGE_NONE, CHANGE_NONE,
+    CHANGE_PRESSURE, CHANGE_PRESSURE, CHANGE_PRESSURE,
+    CHANGE_NONE,
+    CHANGE_TIME_CONSTANT, CHANGE_TIME_CONSTANT, CHANGE_TIME_CONSTANT,
+    CHANGE_NONE, CHANGE_NONE,
+    CHANGE_GNSS, CHANGE_GNSS, CHANGE_GNSS,
+    CHANGE_TIME_CONSTANT,
+    CHANGE_HORIZON
+  };
+
+//! EEPROM model
+static float eeprom[ PARAMETERS];
+static unsigned writes;
+static unsigned write_order[ PARAMETERS];
+static uint32_t failing;	//!< bit n: writing parameter n fails
+
+static unsigned write_parameter( unsigned index, float value)
+{
+  write_order[ writes++] = index;
+  if( failing & ( 1u << index))
+    return CHANGE_NONE;
+  eeprom[ index] = value;
+  return change_class[ index];
+}
+
+static void reset_eeprom( void)
+{
+  for( unsigned i = 0; i < PARAMETERS; ++i)
+    eeprom[i] = 0.0f;
+  writes = 0;
+  failing = 0;
+}
+
+//! a frontend changing the pressure and time constant setup: one notification for both classes
+static void test_coalesced_changes( void)
+{
+  reset_eeprom();
+  config_batch_t < PARAMETERS> batch( TIMEOUT);
+  batch.begin( 100);
+  CHECK( batch.is_open( 100));
+  batch.stage( 4, 1.02f);
+  batch.stage( 7, 2.0f);
+  batch.stage( 8, 30.0f);
+  batch.stage( 1, 0.5f);
+  CHECK( writes == 0);
+
+  CHECK( batch.commit( 200, write_parameter) == ( CHANGE_PRESSURE | CHANGE_TIME_CONSTANT));
+  CHECK( writes == 4);
+  CHECK( eeprom[4] == 1.02f);
+  CHECK( eeprom[7] == 2.0f);
+  CHECK( eeprom[8] == 30.0f);
+  CHECK( eeprom[1] == 0.5f);
+  CHECK( not batch.is_open( 200));
+
+  // written in registry order, not in staging order
+  for( unsigned i = 1; i < writes; ++i)
+    CHECK( write_order[i - 1] < write_order[i]);
+}
+
+//! all change classes at once, each only once
+static void test_all_parameters( void)
+{
+  reset_eeprom();
+  config_batch_t < PARAMETERS> batch( TIMEOUT);
+  batch.begin( 0);
+  for( unsigned i = 0; i < PARAMETERS; ++i)
+    batch.stage( i, (float)i);
+  CHECK( batch.commit( 1, write_parameter) ==
+      ( CHANGE_TIME_CONSTANT | CHANGE_GNSS | CHANGE_PRESSURE | CHANGE_HORIZON));
+  CHECK( writes == PARAMETERS);
+}
+
+//! a parameter staged twice is written once with the latest value
+static void test_latest_value_wins( void)
+{
+  reset_eeprom();
+  config_batch_t < PARAMETERS> batch( TIMEOUT);
+  batch.begin( 0);
+  batch.stage( 12, 1.0f);
+  batch.stage( 12, 1.5f);
+  batch.stage( 12, 1.25f);
+  CHECK( batch.commit( 10, write_parameter) == CHANGE_GNSS);
+  CHECK( writes == 1);
+  CHECK( eeprom[12] == 1.25f);
+}
+
+//! only successful writes contribute their change class
+static void test_failed_write( void)
+{
+  reset_eeprom();
+  failing = 1u << 16;
+  config_batch_t < PARAMETERS> batch( TIMEOUT);
+  batch.begin( 0);
+  batch.stage( 16, 1.0f); // HORIZON fails
+  batch.stage( 5, 3.0f);
+  CHECK( batch.commit( 10, write_parameter) == CHANGE_PRESSURE);
+  CHECK( writes == 2);
+  CHECK( eeprom[16] == 0.0f);
+
+  // parameters without a change class write but notify nothing
+  reset_eeprom();
+  batch.begin( 20);
+  batch.stage( 0, 1.0f);
+  batch.stage( 10, 1.0f);
+  CHECK( batch.commit( 30, write_parameter) == CHANGE_NONE);
+  CHECK( writes == 2);
+}
+
+//! an uncommitted batch is discarded after the timeout, the tick counter may wrap
+static void test_timeout( void)
+{
+  reset_eeprom();
+  config_batch_t < PARAMETERS> batch( TIMEOUT);
+  batch.begin( 0xfffffc00);
+  batch.stage( 3, 1.0f);
+  CHECK( batch.is_open( 0xfffffc00 + TIMEOUT));
+  CHECK( not batch.is_open( 0xfffffc00 + TIMEOUT + 1)); // wrapped
+  CHECK( batch.commit( 0xfffffc00 + TIMEOUT + 1, write_parameter) == 0);
+  CHECK( writes == 0);
+
+  // a commit too late writes nothing either
+  batch.begin( 5000);
+  batch.stage( 3, 1.0f);
+  CHECK( batch.commit( 5000 + TIMEOUT + 1, write_parameter) == 0);
+  CHECK( writes == 0);
+}
+
+//! commit without begin, a second commit, a new batch forgets old staging
+static void test_protocol_errors( void)
+{
+  reset_eeprom();
+  config_batch_t < PARAMETERS> batch( TIMEOUT);
+  CHECK( not batch.is_open( 0));
+  CHECK( batch.commit( 0, write_parameter) == 0);
+
+  batch.begin( 0);
+  batch.stage( 7, 1.0f);
+  batch.stage( PARAMETERS, 1.0f); // out of range, ignored
+  CHECK( batch.commit( 1, write_parameter) == CHANGE_TIME_CONSTANT);
+  CHECK( batch.commit( 2, write_parameter) == 0);
+  CHECK( writes == 1);
+
+  batch.begin( 10);
+  batch.stage( 13, 1.0f);
+  batch.begin( 20); // restarted by the frontend
+  batch.stage( 3, 1.0f);
+  CHECK( batch.commit( 30, write_parameter) == CHANGE_PRESSURE);
+  CHECK( writes == 2);
+  CHECK( write_order[1] == 3);
+}
+
+int main( void)
+{
+  test_coalesced_changes();
+  test_all_parameters();
+  test_latest_value_wins();
+  test_failed_write();
+  test_timeout();
+  test_protocol_errors();
+  return TEST_RESULT();
+}
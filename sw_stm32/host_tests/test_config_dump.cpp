@@ -0,0 +1,242 @@
+/***********************************************************************//**
+ * @file		test_config_dump.cpp
+ * @brief		configuration dump over a simulated CAN pipeline and bus
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#include "host_test.h"
+#include "config_dump.h"
+#include "CAN_bus_timing.h"
+
+enum
+{
+  PARAMETERS = 17,		//!< CAN_PARAMETER_COUNT
+  PARAMETER_OFFSET = 0x2000,
+  CMD_CONFIG_DUMP_ALL = 0x2802,
+  PIPELINE_SIZE = 5,		//!< CAN_pipeline of CAN_output_task.cpp
+  TICK_USEC = 10000,		//!< the CAN task drains the pipeline at 100 Hz
+  FRAME_WAIT = 200,		//!< CONFIG_DUMP_FRAME_WAIT in ticks
+  NO_FAULT = 0xffffffff
+};
+
+//! CANpacket payload layout
+typedef struct
+{
+  uint16_t id;
+  union
+  {
+    uint8_t  data_b[8];
+    uint16_t data_h[4];
+    uint32_t data_w[2];
+    float    data_f[2];
+  };
+} packet_t;
+
+/*!
+ The CAN task, with a higher priority than the CAN listener, empties the pipeline
+ once per tick. The listener blocks on a full pipeline and refills it afterwards.
+ */
+struct CAN_sim_t
+{
+  packet_t pipeline[ PIPELINE_SIZE];
+  unsigned queued;
+  packet_t received[ 64];	//!< frames seen by the frontend
+  unsigned received_count;
+  unsigned ticks;
+  unsigned bus_usec;
+  bool stalled;			//!< CAN task does not run
+
+  void reset( void)
+  {
+    queued = received_count = ticks = bus_usec = 0;
+    stalled = false;
+  }
+
+  void tick( void)
+  {
+    ++ticks;
+    if( stalled)
+      return;
+    for( unsigned i = 0; i < queued; ++i)
+      {
+	received[ received_count++] = pipeline[i];
+	bus_usec += CAN_frame_bits( 8) * 1000000 / CAN_BIT_RATE;
+      }
+    queued = 0;
+  }
+
+  //! CAN_enqueue( packet, FRAME_WAIT)
+  bool enqueue( const packet_t & packet)
+  {
+    for( unsigned wait = 0; queued == PIPELINE_SIZE; ++wait)
+      {
+	if( wait == FRAME_WAIT)
+	  return false;
+	tick();
+      }
+    pipeline[ queued++] = packet;
+    return true;
+  }
+};
+
+static CAN_sim_t bus;
+static float eeprom[ PARAMETERS];
+static unsigned unreadable = NO_FAULT;	//!< CAN index of a parameter that can not be read
+
+static bool read_parameter( unsigned index, float & value)
+{
+  if( index == unreadable)
+    return false;
+  value = eeprom[ index];
+  return true;
+}
+
+static bool send( const packet_t & packet)
+{
+  return bus.enqueue( packet);
+}
+
+//! frontend side: collect the dump, @return true if complete and without gaps
+static bool decode_dump( float * values, bool * present, unsigned & parameter_frames)
+{
+  for( unsigned i = 0; i < PARAMETERS; ++i)
+    present[i] = false;
+  uint8_t expected_sequence = 0;
+  for( unsigned i = 0; i < bus.received_count; ++i)
+    {
+      const packet_t & frame = bus.received[i];
+      if( ( frame.data_b[3] & CONFIG_DUMP_FLAG) == 0)
+	continue; // single get answer
+      if( frame.data_b[2] != expected_sequence++)
+	return false; // lost frame
+      if( frame.data_h[0] == CMD_CONFIG_DUMP_ALL)
+	{
+	  parameter_frames = frame.data_b[3] & ~CONFIG_DUMP_FLAG;
+	  return parameter_frames == frame.data_b[2];
+	}
+      unsigned index = frame.data_h[0] - PARAMETER_OFFSET;
+      if( index >= PARAMETERS)
+	return false;
+      values[ index] = frame.data_f[1];
+      present[ index] = true;
+    }
+  return false; // no end frame
+}
+
+static void dump( void)
+{
+  packet_t txp;
+  txp.id = 0x12f;
+  bus.reset();
+  (void) send_config_dump( txp, PARAMETERS, PARAMETER_OFFSET, CMD_CONFIG_DUMP_ALL, read_parameter, send);
+  while( bus.queued && not bus.stalled)
+    bus.tick();
+}
+
+static void test_complete_dump( void)
+{
+  for( unsigned i = 0; i < PARAMETERS; ++i)
+    eeprom[i] = 0.25f * i - 1.0f;
+  unreadable = NO_FAULT;
+  dump();
+
+  float values[ PARAMETERS];
+  bool present[ PARAMETERS];
+  unsigned parameter_frames = 0;
+  CHECK( bus.received_count == PARAMETERS + 1);
+  CHECK( decode_dump( values, present, parameter_frames));
+  CHECK( parameter_frames == PARAMETERS);
+  for( unsigned i = 0; i < PARAMETERS; ++i)
+    CHECK( present[i] && ( values[i] == eeprom[i]));
+
+  // no dump frame looks like a get answer
+  for( unsigned i = 0; i < bus.received_count; ++i)
+    CHECK( bus.received[i].data_b[3] != 0);
+
+  // 5 frames per CAN task cycle: 18 frames need 4 ticks
+  CHECK( bus.ticks == ( PARAMETERS + 1 + PIPELINE_SIZE - 1) / PIPELINE_SIZE);
+}
+
+//! a parameter that can not be read is skipped without a gap in the sequence
+static void test_unreadable_parameter( void)
+{
+  unreadable = 5;
+  dump();
+  float values[ PARAMETERS];
+  bool present[ PARAMETERS];
+  unsigned parameter_frames = 0;
+  CHECK( decode_dump( values, present, parameter_frames));
+  CHECK( parameter_frames == PARAMETERS - 1);
+  CHECK( not present[5]);
+  CHECK( present[4] && present[6]);
+  unreadable = NO_FAULT;
+}
+
+//! a stalled pipeline: the dump is abandoned without the end frame
+static void test_stalled_pipeline( void)
+{
+  packet_t txp;
+  bus.reset();
+  bus.stalled = true;
+  CHECK( not send_config_dump( txp, PARAMETERS, PARAMETER_OFFSET, CMD_CONFIG_DUMP_ALL, read_parameter, send));
+  CHECK( bus.ticks == FRAME_WAIT);
+  CHECK( bus.queued == PIPELINE_SIZE);
+
+  float values[ PARAMETERS];
+  bool present[ PARAMETERS];
+  unsigned parameter_frames = 0;
+  bus.stalled = false;
+  bus.tick();
+  CHECK( not decode_dump( values, present, parameter_frames));
+}
+
+//! frontend sync time: one dump against one get round trip per parameter
+static void test_sync_time( void)
+{
+  dump();
+  unsigned dump_usec = bus.ticks * TICK_USEC;
+
+  // a get answer is queued by the listener and sent with the next CAN task cycle,
+  // the frontend asks for the next parameter after the answer
+  bus.reset();
+  for( unsigned index = 0; index < PARAMETERS; ++index)
+    {
+      packet_t answer;
+      answer.data_h[0] = PARAMETER_OFFSET + index;
+      answer.data_h[1] = 0;
+      answer.data_f[1] = eeprom[ index];
+      CHECK( bus.enqueue( answer));
+      bus.tick();
+    }
+  unsigned get_usec = bus.ticks * TICK_USEC;
+
+  printf( "parameter sync: dump %u ms, single get requests %u ms, bus time %u us\n",
+      dump_usec / 1000, get_usec / 1000, bus.bus_usec);
+  CHECK( dump_usec * 4 <= get_usec);
+}
+
+int main( void)
+{
+  test_complete_dump();
+  test_unreadable_parameter();
+  test_stalled_pipeline();
+  test_sync_time();
+  return TEST_RESULT();
+}
@@ -0,0 +1,178 @@
+/***********************************************************************//**
+ * @file		test_firmware_digest_cache.cpp
+ * @brief		invalidation rules of the cached firmware digest
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#include <string.h>
+#include "host_test.h"
+#include "firmware_digest_cache.h"
+
+enum { IMAGE_BYTES = 200 * 1024 + 6 }; //!< not a multiple of 4, as __fini_array_end may be
+
+static uint8_t image[ IMAGE_BYTES + 4];
+
+//! STM32F4 CRC unit: CRC-32 polynomial, initial value all ones, 32 bit words, no reflection
+static uint32_t image_crc( const uint8_t * start, uint32_t size)
+{
+  uint32_t crc = 0xffffffff;
+  const uint32_t * end = (const uint32_t *)( start + ( ( size + 3) & ~3));
+  for( const uint32_t * word = (const uint32_t *)start; word < end; ++word)
+    {
+      crc ^= *word;
+      for( unsigned bit = 0; bit < 32; ++bit)
+	crc = ( crc & 0x80000000) ? ( crc << 1) ^ 0x04C11DB7 : crc << 1;
+    }
+  return crc;
+}
+
+//! stand-in for SHA256, only identity matters here
+static void make_digest( const uint8_t * start, uint32_t size, uint8_t * digest)
+{
+  memset( digest, 0, 32);
+  for( uint32_t i = 0; i < size; ++i)
+    digest[ i % 32] ^= start[i] + i;
+}
+
+//! EEPROM file system blob
+static firmware_digest_record_t stored;
+static bool stored_valid;
+static unsigned full_hashes;
+
+//! make_firmware_digest(): @return digest as provided at boot
+static void boot( uint32_t size, uint8_t * digest)
+{
+  uint32_t crc = image_crc( image, size);
+  if( stored_valid && firmware_digest_record_valid( stored, crc, size))
+    {
+      memcpy( digest, stored.digest, 32);
+      return;
+    }
+  ++full_hashes;
+  make_digest( image, size, digest);
+  stored.image_crc = crc;
+  stored.image_size = size;
+  memcpy( stored.digest, digest, 32);
+  stored_valid = true;
+}
+
+static void load_image( uint32_t seed)
+{
+  for( unsigned i = 0; i < sizeof( image); ++i)
+    image[i] = (uint8_t)( ( i * 2654435761u + seed) >> 13);
+}
+
+//! first boot hashes and stores, further boots of the same image use the cache
+static void test_cache_hit( void)
+{
+  load_image( 1);
+  stored_valid = false;
+  full_hashes = 0;
+  uint8_t first[32], second[32];
+  boot( IMAGE_BYTES, first);
+  CHECK( full_hashes == 1);
+  boot( IMAGE_BYTES, second);
+  boot( IMAGE_BYTES, second);
+  CHECK( full_hashes == 1);
+  CHECK( memcmp( first, second, 32) == 0);
+}
+
+//! any flipped bit of the program invalidates the cache, the CRC catches all single bit errors
+static void test_modified_image( void)
+{
+  static const unsigned positions[] = { 0, 1, 1000, 65537, IMAGE_BYTES / 2, IMAGE_BYTES - 1 };
+  uint8_t digest[32], reference[32];
+  for( unsigned position : positions)
+    for( unsigned bit = 0; bit < 8; bit += 3)
+      {
+	load_image( 1);
+	stored_valid = false;
+	boot( IMAGE_BYTES, digest);
+	full_hashes = 0;
+
+	image[ position] ^= 1 << bit;
+	boot( IMAGE_BYTES, digest);
+	CHECK( full_hashes == 1);
+	make_digest( image, IMAGE_BYTES, reference);
+	CHECK( memcmp( digest, reference, 32) == 0);
+      }
+}
+
+//! same content, different length: the size is part of the key
+static void test_size_change( void)
+{
+  uint8_t digest[32];
+  load_image( 2);
+  stored_valid = false;
+  boot( IMAGE_BYTES, digest);
+  full_hashes = 0;
+
+  // a record with the right CRC and a wrong size is not accepted
+  firmware_digest_record_t record = stored;
+  record.image_size = IMAGE_BYTES - 1; // same CRC: the padded words are identical
+  CHECK( image_crc( image, IMAGE_BYTES - 1) == record.image_crc);
+  CHECK( not firmware_digest_record_valid( record, record.image_crc, IMAGE_BYTES));
+
+  boot( IMAGE_BYTES - 1, digest);
+  CHECK( full_hashes == 1);
+  boot( IMAGE_BYTES + 4, digest);
+  CHECK( full_hashes == 2);
+}
+
+//! a firmware update replaces the record, going back needs a new hash as well
+static void test_firmware_update( void)
+{
+  uint8_t old_digest[32], new_digest[32], digest[32];
+  load_image( 3);
+  stored_valid = false;
+  full_hashes = 0;
+  boot( IMAGE_BYTES, old_digest);
+  load_image( 4);
+  boot( IMAGE_BYTES, new_digest);
+  CHECK( full_hashes == 2);
+  CHECK( memcmp( old_digest, new_digest, 32) != 0);
+  boot( IMAGE_BYTES, digest);
+  CHECK( full_hashes == 2);
+  load_image( 3);
+  boot( IMAGE_BYTES, digest);
+  CHECK( full_hashes == 3);
+  CHECK( memcmp( old_digest, digest, 32) == 0);
+}
+
+//! erased or cleared EEPROM content is never taken for a record
+static void test_blank_record( void)
+{
+  firmware_digest_record_t record;
+  memset( &record, 0xff, sizeof( record));
+  CHECK( not firmware_digest_record_valid( record, 0xffffffff, IMAGE_BYTES));
+  memset( &record, 0, sizeof( record));
+  CHECK( not firmware_digest_record_valid( record, 0, IMAGE_BYTES));
+  CHECK( sizeof( firmware_digest_record_t) % sizeof( uint32_t) == 0); // stored as words
+}
+
+int main( void)
+{
+  test_cache_hit();
+  test_modified_image();
+  test_size_change();
+  test_firmware_update();
+  test_blank_record();
+  return TEST_RESULT();
+}
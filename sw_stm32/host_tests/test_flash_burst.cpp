@@ -0,0 +1,284 @@
+/***********************************************************************//**
+ * @file		test_flash_burst.cpp
+ * @brief		interrupt-chained flash programming on a simulated flash controller
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#include <string.h>
+#include "host_test.h"
+#include "flash_burst.h"
+
+//! modelled STM32F407 timing in usec
+enum
+{
+  PROGRAM_US = 16,	//!< typical word programming time
+  ISR_US = 2,		//!< HAL_FLASH_IRQHandler and the chaining code
+  WAKE_US = 15,		//!< semaphore signal from ISR and task switch
+  UNLOCK_US = 1,	//!< HAL_FLASH_Unlock / HAL_FLASH_Lock
+  FLASH_WORDS = 4096,
+  NO_FAULT = 0xffffffff
+};
+
+/*!
+ Flash controller and HAL driver model.
+ A started word completes PROGRAM_US later, then the interrupt runs the HAL handler,
+ which calls the end-of-operation or error callback, and the ISR code of
+ EEPROM_data_file_implementation.cpp.
+ */
+struct flash_sim_t
+{
+  uint32_t memory[ FLASH_WORDS];
+  bool locked;
+  bool busy;		//!< HAL procedure ongoing
+  uint32_t * pending_dest;
+  uint32_t pending_value;
+  unsigned unlock_cycles;
+  unsigned words_started;
+  unsigned wakes;
+  unsigned time_us;
+  unsigned error_at_word;	//!< operation error for this word
+  unsigned refuse_at_word;	//!< HAL_FLASH_Program_IT returns an error
+  flash_burst_t burst;
+
+  void reset( void)
+  {
+    memset( memory, 0xff, sizeof( memory));
+    locked = true;
+    busy = false;
+    unlock_cycles = words_started = wakes = time_us = 0;
+    error_at_word = refuse_at_word = NO_FAULT;
+  }
+
+  void unlock( void)
+  {
+    ++unlock_cycles;
+    locked = false;
+    time_us += UNLOCK_US;
+  }
+
+  void lock( void)
+  {
+    locked = true;
+    time_us += UNLOCK_US;
+  }
+
+  //! HAL_FLASH_Program_IT
+  bool program( uint32_t *dest, uint32_t value)
+  {
+    if( locked || busy || ( words_started == refuse_at_word))
+      return false;
+    busy = true;
+    pending_dest = dest;
+    pending_value = value;
+    ++words_started;
+    return true;
+  }
+
+  //! time passes until the running operation completes, then FLASH_IRQHandler
+  //! @return true if the ISR woke the task
+  bool interrupt( void)
+  {
+    time_us += PROGRAM_US + ISR_US;
+    busy = false;
+    if( words_started - 1 == error_at_word)
+      burst.operation_error();
+    else
+      {
+	*pending_dest &= pending_value; // programming can only clear bits
+	burst.end_of_operation();
+      }
+
+    uint32_t * dest;
+    uint32_t value;
+    switch( burst.step( dest, value))
+      {
+      case flash_burst_t::STEP_BUSY:
+	break;
+      case flash_burst_t::STEP_PROGRAM:
+	if( program( dest, value))
+	  break;
+	burst.program_refused();
+	// fall through
+      case flash_burst_t::STEP_DONE:
+	++wakes;
+	time_us += WAKE_US;
+	return true;
+      }
+    return false;
+  }
+
+  //! FLASH_write() with a synchronized burst
+  bool write( uint32_t *dest, const uint32_t *source, unsigned n_words)
+  {
+    unlock();
+    bool result = burst.start( dest, source, n_words) && program( dest, *source);
+    if( result)
+      {
+	while( not interrupt())
+	  ;
+	result = not burst.has_failed();
+      }
+    lock();
+    return result;
+  }
+
+  //! previous scheme: every word a separate order for the EEPROM writer task
+  bool write_word_by_word( uint32_t *dest, const uint32_t *source, unsigned n_words)
+  {
+    while( n_words--)
+      if( not write( dest++, source++, 1))
+	return false;
+    return true;
+  }
+};
+
+static flash_sim_t flash;
+
+static uint32_t pattern( unsigned i)
+{
+  return i * 2654435761u;
+}
+
+static bool programmed( unsigned offset, unsigned n_words)
+{
+  for( unsigned i = 0; i < n_words; ++i)
+    if( flash.memory[ offset + i] != pattern( i))
+      return false;
+  return true;
+}
+
+static bool erased( unsigned offset, unsigned n_words)
+{
+  for( unsigned i = 0; i < n_words; ++i)
+    if( flash.memory[ offset + i] != 0xffffffff)
+      return false;
+  return true;
+}
+
+//! one unlock cycle and one task wake-up per block, whatever its size
+static void test_block_sizes( void)
+{
+  static const unsigned sizes[] = { 1, 2, 9, 100, 2048 };
+  static uint32_t source[ 2048];
+  for( unsigned i = 0; i < 2048; ++i)
+    source[i] = pattern( i);
+
+  for( unsigned size : sizes)
+    {
+      flash.reset();
+      CHECK( flash.write( flash.memory + 16, source, size));
+      CHECK( programmed( 16, size));
+      CHECK( erased( 0, 16));
+      CHECK( erased( 16 + size, FLASH_WORDS - 16 - size));
+      CHECK( flash.words_started == size);
+      CHECK( flash.unlock_cycles == 1);
+      CHECK( flash.wakes == 1);
+      CHECK( flash.time_us == size * ( PROGRAM_US + ISR_US) + WAKE_US + 2 * UNLOCK_US);
+      CHECK( flash.locked);
+
+      unsigned burst_us = flash.time_us;
+      flash.reset();
+      CHECK( flash.write_word_by_word( flash.memory + 16, source, size));
+      CHECK( programmed( 16, size));
+      CHECK( flash.unlock_cycles == size);
+      CHECK( flash.wakes == size);
+      CHECK( burst_us <= flash.time_us);
+
+      printf( "%4u words: burst %6u us, word by word %6u us, %u unlock cycles saved\n",
+	  size, burst_us, flash.time_us, size - 1);
+    }
+}
+
+//! n_words has to be explicit, a count of 0 starts nothing
+static void test_zero_words( void)
+{
+  uint32_t word = 0;
+  flash.reset();
+  CHECK( not flash.write( flash.memory, &word, 0));
+  CHECK( flash.words_started == 0);
+  CHECK( erased( 0, FLASH_WORDS));
+}
+
+//! an operation error ends the chain, the task is woken once and sees the failure
+static void test_operation_error( void)
+{
+  static uint32_t source[ 20];
+  for( unsigned i = 0; i < 20; ++i)
+    source[i] = pattern( i);
+
+  flash.reset();
+  flash.error_at_word = 5;
+  CHECK( not flash.write( flash.memory, source, 20));
+  CHECK( programmed( 0, 5));
+  CHECK( erased( 5, FLASH_WORDS - 5));
+  CHECK( flash.words_started == 6);
+  CHECK( flash.wakes == 1);
+
+  // the next burst starts clean
+  flash.error_at_word = NO_FAULT;
+  CHECK( flash.write( flash.memory + 100, source, 20));
+  CHECK( programmed( 100, 20));
+  CHECK( flash.wakes == 2);
+}
+
+//! the HAL refuses the next word in the ISR: the chain stops, the task is woken
+static void test_refused_word( void)
+{
+  static uint32_t source[ 10];
+  for( unsigned i = 0; i < 10; ++i)
+    source[i] = pattern( i);
+
+  flash.reset();
+  flash.refuse_at_word = 3;
+  CHECK( not flash.write( flash.memory, source, 10));
+  CHECK( programmed( 0, 3));
+  CHECK( erased( 3, FLASH_WORDS - 3));
+  CHECK( flash.wakes == 1);
+}
+
+//! after a timeout abort() a late completion must not start another word
+static void test_abort( void)
+{
+  static uint32_t source[ 10];
+  for( unsigned i = 0; i < 10; ++i)
+    source[i] = pattern( i);
+
+  flash.reset();
+  flash.unlock();
+  CHECK( flash.burst.start( flash.memory, source, 10));
+  CHECK( flash.program( flash.memory, source[0]));
+  CHECK( not flash.interrupt()); // second word started
+  flash.burst.abort(); // task timed out
+  CHECK( flash.interrupt()); // late completion wakes, nothing started
+  CHECK( flash.words_started == 2);
+  CHECK( flash.burst.has_failed());
+  CHECK( programmed( 0, 2));
+  CHECK( erased( 2, FLASH_WORDS - 2));
+}
+
+int main( void)
+{
+  test_block_sizes();
+  test_zero_words();
+  test_operation_error();
+  test_refused_word();
+  test_abort();
+  return TEST_RESULT();
+}
@@ -0,0 +1,147 @@
+/***********************************************************************//**
+ * @file		test_log_file_index.cpp
+ * @brief		log file index: resolution halving and time search
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#include <vector>
+#include "host_test.h"
+#include "log_file_index.h"
+#include "log_slot_ring.h"
+
+enum { SIZE = 8};
+
+//! entries stay evenly spaced in time while the table halves its resolution
+static void test_halving( void)
+{
+  log_index_table_t < SIZE> index;
+  CHECK( index.get_count() == 0);
+
+  for( unsigned i = 0; i < SIZE; ++i)
+    index.add( i * 10, i * 1000);
+  CHECK( index.get_count() == SIZE);
+
+  index.add( SIZE * 10, SIZE * 1000); // full: keep every second entry
+  CHECK( index.get_count() == SIZE / 2 + 1);
+
+  for( unsigned i = SIZE + 1; i < 100; ++i)
+    index.add( i * 10, i * 1000);
+
+  const log_index_entry_t * entry = index.get_entries();
+  unsigned count = index.get_count();
+  CHECK( count > SIZE / 2);
+  CHECK( count <= SIZE);
+  CHECK( entry[0].time == 0);
+  CHECK( entry[0].offset == 0);
+  uint32_t spacing = entry[1].time - entry[0].time;
+  CHECK( spacing == 160); // 100 calls into 8 entries: stride 16
+  for( unsigned i = 1; i < count; ++i)
+    {
+      CHECK( entry[i].time - entry[i - 1].time == spacing);
+      CHECK( entry[i].offset == entry[i].time * 100);
+    }
+
+  index.reset();
+  CHECK( index.get_count() == 0);
+  index.add( 5, 7);
+  CHECK( index.get_count() == 1);
+  CHECK( index.get_entries()[0].time == 5);
+}
+
+static void test_search( void)
+{
+  log_index_entry_t entry[ 5];
+  for( unsigned i = 0; i < 5; ++i)
+    {
+      entry[i].time = 100 + i * 10;
+      entry[i].offset = i;
+    }
+
+  CHECK( find_log_index_entry( entry, 0, 100) == 0);
+  CHECK( find_log_index_entry( entry, 5, 99) == 0);
+  CHECK( find_log_index_entry( entry, 5, 100) == entry);
+  CHECK( find_log_index_entry( entry, 5, 109) == entry);
+  CHECK( find_log_index_entry( entry, 5, 110) == entry + 1);
+  CHECK( find_log_index_entry( entry, 5, 135) == entry + 3);
+  CHECK( find_log_index_entry( entry, 5, 140) == entry + 4);
+  CHECK( find_log_index_entry( entry, 5, 1000000) == entry + 4);
+  CHECK( find_log_index_entry( entry, 1, 5000) == entry);
+
+  for( uint32_t time = 100; time < 160; ++time) // against a linear scan
+    {
+      const log_index_entry_t * expected = entry;
+      for( unsigned i = 0; i < 5; ++i)
+	if( entry[i].time <= time)
+	  expected = entry + i;
+      CHECK( find_log_index_entry( entry, 5, time) == expected);
+    }
+}
+
+//! index records written while the uSD card is stalled point to where they end up in the file
+static void test_overrun( void)
+{
+  enum { SLOTS = 4, SLOT_WORDS = 16, RECORD_WORDS = 5, RECORDS = 40};
+  uint32_t buffer[ SLOTS * SLOT_WORDS];
+  log_slot_ring_t ring( buffer, SLOTS * SLOT_WORDS, SLOTS);
+  log_index_table_t < RECORDS> index;
+  std::vector <uint32_t> file;
+
+  for( uint32_t time = 0; time < RECORDS; ++time)
+    {
+      // as flexible_log_file_implementation_t::append_index(): offset taken after make_room()
+      if( not ring.make_room( RECORD_WORDS))
+	continue;
+      index.add( time, ring.get_position() * sizeof( uint32_t));
+      log_span_t span = ring.reserve( RECORD_WORDS);
+      for( unsigned i = 0; i < RECORD_WORDS; ++i)
+	( i < span.first_words ? span.first[i] : span.second[ i - span.first_words]) = time;
+      ring.commit( RECORD_WORDS);
+
+      if( time >= 25) // the card responds again
+	while( uint32_t * slot = ring.get_completed_slot())
+	  {
+	    file.insert( file.end(), slot, slot + SLOT_WORDS);
+	    ring.release_slot();
+	  }
+    }
+  CHECK( ring.get_overrun_count() > 0);
+
+  CHECK( index.get_count() == RECORDS);
+
+  // every record that made it into the file is found at its index offset
+  const log_index_entry_t * entry = index.get_entries();
+  unsigned found = 0;
+  for( unsigned word = 0; word + RECORD_WORDS <= file.size(); word += RECORD_WORDS)
+    {
+      uint32_t time = file[ word];
+      CHECK( entry[ time].offset == word * sizeof( uint32_t));
+      ++found;
+    }
+  CHECK( found > 0);
+  CHECK( found < RECORDS);
+}
+
+int main( void)
+{
+  test_halving();
+  test_search();
+  test_overrun();
+  return TEST_RESULT();
+}
@@ -0,0 +1,268 @@
+/***********************************************************************//**
+ * @file		test_log_file_reservation.cpp
+ * @brief		log file pre-allocation on a FatFs RAM disk: close, power loss, reclaim
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#include <string.h>
+#include <vector>
+#include "host_test.h"
+#include "diskio.h"
+#include "log_file_reservation.h"
+
+enum
+{
+  SECTOR_SIZE = 512,
+  SECTORS = 32768,		//!< 16 MB RAM disk
+  RESERVATION = 1024 * 1024,
+  SLOT_BYTES = 2048,		//!< one slot of the log ring buffer
+  DATA_BYTES = 100 * 1024
+};
+
+static std::vector <BYTE> disk( SECTORS * SECTOR_SIZE);
+static FATFS fatfs;
+static unsigned FAT_sector_writes;
+
+extern "C" DSTATUS disk_initialize( BYTE)
+{
+  return 0;
+}
+
+extern "C" DSTATUS disk_status( BYTE)
+{
+  return 0;
+}
+
+extern "C" DRESULT disk_read( BYTE, BYTE * buff, DWORD sector, UINT count)
+{
+  memcpy( buff, &disk[ sector * SECTOR_SIZE], count * SECTOR_SIZE);
+  return RES_OK;
+}
+
+extern "C" DRESULT disk_write( BYTE, const BYTE * buff, DWORD sector, UINT count)
+{
+  if( ( sector < fatfs.fatbase + fatfs.n_fats * fatfs.fsize) && ( sector + count > fatfs.fatbase))
+    ++FAT_sector_writes;
+  memcpy( &disk[ sector * SECTOR_SIZE], buff, count * SECTOR_SIZE);
+  return RES_OK;
+}
+
+extern "C" DRESULT disk_ioctl( BYTE, BYTE cmd, void * buff)
+{
+  switch( cmd)
+  {
+    case GET_SECTOR_COUNT:
+      *(DWORD *)buff = SECTORS;
+      break;
+    case GET_SECTOR_SIZE:
+      *(WORD *)buff = SECTOR_SIZE;
+      break;
+    case GET_BLOCK_SIZE:
+      *(DWORD *)buff = 1;
+      break;
+    default:
+      break;
+  }
+  return RES_OK;
+}
+
+extern "C" DWORD get_fattime( void)
+{
+  return ( 46u << 25) | ( 1 << 21) | ( 1 << 16);
+}
+
+static void format( void)
+{
+  BYTE work[ _MAX_SS];
+  CHECK( f_mkfs( "", FM_ANY, 0, work, sizeof( work)) == FR_OK);
+  CHECK( f_mount( &fatfs, "", 1) == FR_OK);
+  CHECK( f_mkdir( "logger") == FR_OK);
+}
+
+static DWORD free_clusters( void)
+{
+  DWORD clusters = 0;
+  FATFS * fs;
+  CHECK( f_getfree( "", &clusters, &fs) == FR_OK);
+  return clusters;
+}
+
+static DWORD clusters( FSIZE_t bytes)
+{
+  DWORD cluster_bytes = fatfs.csize * SECTOR_SIZE;
+  return ( bytes + cluster_bytes - 1) / cluster_bytes;
+}
+
+static bool reservation_recorded( void)
+{
+  FILINFO info;
+  return f_stat( LOG_RESERVATION_FILE, &info) == FR_OK;
+}
+
+//! open like flexible_log_file_implementation_t and write bytes in slot sized blocks
+static void open_and_write( FIL * file, DWORD * cluster_map, const char * name, unsigned bytes)
+{
+  CHECK( record_log_file_reservation( name) == FR_OK);
+  CHECK( f_open( file, name, FA_CREATE_ALWAYS | FA_WRITE) == FR_OK);
+  CHECK( reserve_log_file( file, RESERVATION, cluster_map) == FR_OK);
+  CHECK( f_size( file) == 0);
+  FAT_sector_writes = 0;
+
+  BYTE slot[ SLOT_BYTES];
+  for( unsigned written = 0; written < bytes; written += SLOT_BYTES)
+    {
+      for( unsigned i = 0; i < SLOT_BYTES; ++i)
+	slot[i] = (BYTE)( ( written + i) * 7);
+      UINT written_bytes;
+      CHECK( f_write( file, slot, SLOT_BYTES, &written_bytes) == FR_OK);
+      CHECK( written_bytes == SLOT_BYTES);
+      if( written % ( 16 * SLOT_BYTES) == 0)
+	CHECK( f_sync( file) == FR_OK);
+    }
+}
+
+static bool content_valid( const char * name, unsigned bytes)
+{
+  FIL file;
+  if( f_open( &file, name, FA_READ) != FR_OK)
+    return false;
+  bool valid = f_size( &file) == bytes;
+  BYTE data[ SLOT_BYTES];
+  for( unsigned offset = 0; valid && offset < bytes; offset += SLOT_BYTES)
+    {
+      UINT read_bytes;
+      valid = ( f_read( &file, data, SLOT_BYTES, &read_bytes) == FR_OK) && ( read_bytes == SLOT_BYTES);
+      for( unsigned i = 0; valid && i < SLOT_BYTES; ++i)
+	valid = data[i] == (BYTE)( ( offset + i) * 7);
+    }
+  f_close( &file);
+  return valid;
+}
+
+//! no FAT update while writing into the reserved area, close releases the rest
+static void test_close( void)
+{
+  format();
+  DWORD free_at_start = free_clusters();
+
+  FIL file;
+  DWORD cluster_map[ 4];
+  FAT_sector_writes = 0;
+  CHECK( record_log_file_reservation( "logger/close.lrsx") == FR_OK);
+  CHECK( f_open( &file, "logger/close.lrsx", FA_CREATE_ALWAYS | FA_WRITE) == FR_OK);
+  CHECK( reserve_log_file( &file, RESERVATION, cluster_map) == FR_OK);
+  CHECK( FAT_sector_writes > 0); // the chain
+  CHECK( free_clusters() <= free_at_start - clusters( RESERVATION));
+  CHECK( reservation_recorded());
+  CHECK( f_close( &file) == FR_OK);
+
+  open_and_write( &file, cluster_map, "logger/flight.lrsx", DATA_BYTES);
+  CHECK( FAT_sector_writes == 0); // data and f_sync only write data and directory sectors
+  CHECK( close_log_file( &file) == FR_OK);
+  CHECK( FAT_sector_writes > 0); // release of the unused chain
+
+  CHECK( not reservation_recorded());
+  CHECK( content_valid( "logger/flight.lrsx", DATA_BYTES));
+  // the first file has been closed without releasing its chain, remove it now
+  CHECK( f_unlink( "logger/close.lrsx") == FR_OK);
+  CHECK( free_clusters() == free_at_start - clusters( DATA_BYTES));
+}
+
+//! writes only while power is on: the chain behind the synced size is released at the next boot
+static void test_power_loss( void)
+{
+  format();
+  DWORD free_at_start = free_clusters();
+
+  FIL file;
+  DWORD cluster_map[ 4];
+  open_and_write( &file, cluster_map, "logger/flight.lrsx", DATA_BYTES);
+  CHECK( f_sync( &file) == FR_OK);
+  BYTE lost[ SLOT_BYTES] = { 0};
+  UINT written_bytes;
+  CHECK( f_write( &file, lost, SLOT_BYTES, &written_bytes) == FR_OK); // not synced
+
+  CHECK( f_mount( 0, "", 0) == FR_OK); // power loss, nothing written any more
+  CHECK( f_mount( &fatfs, "", 1) == FR_OK);
+
+  CHECK( reservation_recorded());
+  CHECK( free_clusters() <= free_at_start - clusters( RESERVATION)); // lost without reclaim
+  CHECK( reclaim_log_file_reservation() == FR_OK);
+
+  CHECK( not reservation_recorded());
+  CHECK( content_valid( "logger/flight.lrsx", DATA_BYTES));
+  CHECK( free_clusters() == free_at_start - clusters( DATA_BYTES));
+
+  CHECK( reclaim_log_file_reservation() == FR_OK); // nothing left to do
+  CHECK( free_clusters() == free_at_start - clusters( DATA_BYTES));
+}
+
+//! power loss before anything has been synced: the whole chain is released
+static void test_power_loss_empty( void)
+{
+  format();
+  DWORD free_at_start = free_clusters();
+
+  FIL file;
+  DWORD cluster_map[ 4];
+  open_and_write( &file, cluster_map, "logger/empty.lrsx", 0);
+  CHECK( f_mount( 0, "", 0) == FR_OK);
+  CHECK( f_mount( &fatfs, "", 1) == FR_OK);
+
+  CHECK( reclaim_log_file_reservation() == FR_OK);
+  CHECK( not reservation_recorded());
+  CHECK( content_valid( "logger/empty.lrsx", 0));
+  CHECK( free_clusters() == free_at_start);
+}
+
+//! truncate at close exactly at a cluster boundary and with an empty file
+static void test_truncate( void)
+{
+  format();
+  DWORD free_at_start = free_clusters();
+  unsigned cluster_bytes = fatfs.csize * SECTOR_SIZE;
+
+  FIL file;
+  DWORD cluster_map[ 4];
+  unsigned bytes = 4 * ( cluster_bytes > (unsigned)SLOT_BYTES ? cluster_bytes : (unsigned)SLOT_BYTES);
+  open_and_write( &file, cluster_map, "logger/aligned.lrsx", bytes);
+  CHECK( close_log_file( &file) == FR_OK);
+  CHECK( content_valid( "logger/aligned.lrsx", bytes));
+  CHECK( free_clusters() == free_at_start - clusters( bytes));
+
+  open_and_write( &file, cluster_map, "logger/empty.lrsx", 0);
+  CHECK( close_log_file( &file) == FR_OK);
+  CHECK( content_valid( "logger/empty.lrsx", 0));
+  CHECK( free_clusters() == free_at_start - clusters( bytes));
+
+  // the recorded file has gone meanwhile
+  CHECK( record_log_file_reservation( "logger/missing.lrsx") == FR_OK);
+  CHECK( reclaim_log_file_reservation() == FR_OK);
+  CHECK( not reservation_recorded());
+}
+
+int main( void)
+{
+  test_close();
+  test_power_loss();
+  test_power_loss_empty();
+  test_truncate();
+  return TEST_RESULT();
+}
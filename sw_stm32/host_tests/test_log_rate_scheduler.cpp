@@ -0,0 +1,160 @@
+/***********************************************************************//**
+ * @file		test_log_rate_scheduler.cpp
+ * @brief		log rate scheduler and log statistics counters
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#include "host_test.h"
+#include "log_rate_scheduler.h"
+#include "log_statistics.h"
+
+//! defaults as in communicator.cpp with LOG_STATISTICS_INTERVAL_S = 10
+static const uint16_t default_decimation[ LOG_STREAM_COUNT] = { 1, 1, 1, 10, 1000 };
+
+//! every enabled stream at its first occasion, then every n-th
+static void test_pattern( void)
+{
+  static const uint16_t decimation[ LOG_STREAM_COUNT] = { 2, 0, 1, 3, 7 };
+  log_rate_scheduler_t scheduler( decimation);
+
+  for( unsigned occasion = 0; occasion < 100; ++occasion)
+    {
+      CHECK( scheduler.due( LOG_STREAM_SENSOR)		== ( occasion % 2 == 0));
+      CHECK( scheduler.due( LOG_STREAM_MAGNETOMETER)	== false);
+      CHECK( scheduler.due( LOG_STREAM_GNSS)		== true);
+      CHECK( scheduler.due( LOG_STREAM_D_GNSS_ACC)	== ( occasion % 3 == 0));
+      CHECK( scheduler.due( LOG_STREAM_STATISTICS)	== ( occasion % 7 == 0));
+    }
+}
+
+//! a new log file starts with all streams, a new profile takes effect at once
+static void test_restart( void)
+{
+  log_rate_scheduler_t scheduler( default_decimation);
+  CHECK( scheduler.due( LOG_STREAM_STATISTICS));
+  for( unsigned tick = 1; tick < 500; ++tick)
+    CHECK( not scheduler.due( LOG_STREAM_STATISTICS));
+  scheduler.restart();
+  CHECK( scheduler.due( LOG_STREAM_STATISTICS));
+
+  static const uint16_t slow[ LOG_STREAM_COUNT] = { 10, 10, 5, 0, 100 };
+  scheduler.set_profile( slow);
+  CHECK( scheduler.get_decimation( LOG_STREAM_SENSOR) == 10);
+  CHECK( scheduler.due( LOG_STREAM_SENSOR));
+  CHECK( not scheduler.due( LOG_STREAM_D_GNSS_ACC));
+}
+
+//! counts over 10 minutes of 100 Hz ticks with 10 Hz GNSS, half of it with heading
+static void test_default_counts( void)
+{
+  log_rate_scheduler_t scheduler( default_decimation);
+  unsigned count[ LOG_STREAM_COUNT] = { 0 };
+
+  for( unsigned tick = 0; tick < 60000; ++tick)
+    {
+      if( scheduler.due( LOG_STREAM_SENSOR))
+	++count[ LOG_STREAM_SENSOR];
+      if( scheduler.due( LOG_STREAM_MAGNETOMETER))
+	++count[ LOG_STREAM_MAGNETOMETER];
+      if( scheduler.due( LOG_STREAM_STATISTICS))
+	++count[ LOG_STREAM_STATISTICS];
+      if( tick % 10 == 0)
+	if( scheduler.due( LOG_STREAM_GNSS))
+	  {
+	    ++count[ LOG_STREAM_GNSS];
+	    if( tick >= 30000) // D_GNSS_DATA
+	      if( scheduler.due( LOG_STREAM_D_GNSS_ACC))
+		++count[ LOG_STREAM_D_GNSS_ACC];
+	  }
+    }
+
+  CHECK( count[ LOG_STREAM_SENSOR] == 60000);
+  CHECK( count[ LOG_STREAM_MAGNETOMETER] == 60000);
+  CHECK( count[ LOG_STREAM_GNSS] == 6000);
+  CHECK( count[ LOG_STREAM_D_GNSS_ACC] == 300);
+  CHECK( count[ LOG_STREAM_STATISTICS] == 60);
+}
+
+//! rates file keys as read by read_log_rates_file()
+static void test_stream_names( void)
+{
+  for( unsigned stream = 0; stream < LOG_STREAM_COUNT; ++stream)
+    CHECK( find_log_stream( log_stream_name( stream)) == stream);
+
+  CHECK( find_log_stream( "MAGNETOMETER_DATA = 10") == LOG_STREAM_MAGNETOMETER);
+  CHECK( find_log_stream( "GNSS_DATA=2") == LOG_STREAM_GNSS);
+  CHECK( find_log_stream( "D_GNSS_ACC\t5") == LOG_STREAM_D_GNSS_ACC);
+  CHECK( find_log_stream( "GNSS_DATA_X = 2") == LOG_STREAM_COUNT);
+  CHECK( find_log_stream( "GNSS") == LOG_STREAM_COUNT);
+  CHECK( find_log_stream( "# BASIC_SENSOR_DATA = 1") == LOG_STREAM_COUNT);
+  CHECK( log_stream_name( LOG_STREAM_COUNT) == 0);
+}
+
+static void test_latency_buckets( void)
+{
+  CHECK( latency_bucket( 0) == 0);
+  CHECK( latency_bucket( 1) == 0);
+  CHECK( latency_bucket( 2) == 1);
+  CHECK( latency_bucket( 3) == 1);
+  CHECK( latency_bucket( 1023) == 9);
+  CHECK( latency_bucket( 1024) == 10);
+  CHECK( latency_bucket( 0xffffffff) == LATENCY_BUCKETS - 1);
+}
+
+static void test_latency_histogram( void)
+{
+  latency_histogram_t histogram;
+  histogram.reset();
+  CHECK( histogram.get_total() == 0);
+  CHECK( histogram.percentile( 99) == 0);
+
+  // 98 fast writes about 1 ms, two slow ones about 100 ms
+  for( unsigned i = 0; i < 98; ++i)
+    histogram.add( 1000);
+  histogram.add( 100000);
+  histogram.add( 120000);
+
+  CHECK( histogram.get_total() == 100);
+  CHECK( histogram.bucket[ latency_bucket( 1000)] == 98);
+  CHECK( histogram.percentile( 50) == 1023);
+  CHECK( histogram.percentile( 98) == 1023);
+  CHECK( histogram.percentile( 99) == 131071);
+  CHECK( histogram.percentile( 100) == 131071);
+
+  histogram.decay();
+  CHECK( histogram.bucket[ latency_bucket( 1000)] == 49);
+  CHECK( histogram.bucket[ latency_bucket( 100000)] == 1);
+  CHECK( histogram.get_total() == 50);
+
+  histogram.add( 0xffffffff);
+  CHECK( histogram.bucket[ LATENCY_BUCKETS - 1] == 1);
+  CHECK( histogram.percentile( 100) == ( 2u << ( LATENCY_BUCKETS - 1)) - 1);
+}
+
+int main( void)
+{
+  test_pattern();
+  test_restart();
+  test_default_counts();
+  test_stream_names();
+  test_latency_buckets();
+  test_latency_histogram();
+  return TEST_RESULT();
+}
@@ -0,0 +1,332 @@
+/***********************************************************************//**
+ * @file		test_log_slot_ring.cpp
+ * @brief		log slot ring: replay of uSD write latency traces, overrun handling
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#include <vector>
+#include <chrono>
+#include <string.h>
+#include "host_test.h"
+#include "log_slot_ring.h"
+
+enum
+{
+  BUFFER_WORDS = 16384 / 4,	//!< mem_buffer of the target
+  SLOTS = 8,			//!< LOG_BUFFER_SLOTS
+  RECORD_WORDS = 64,		//!< logged data per 100 Hz tick
+  TICK_USEC = 10000
+};
+
+//! uSD write latency per slot in ms, modelled on a cheap card:
+//! mostly a few ms, sometimes tens of ms and garbage collection stalls above 300 ms
+static const unsigned latency_trace_ms[] =
+{
+  3, 3, 4, 3, 12, 3, 3, 45, 3, 3, 310, 3, 4, 3, 3, 3, 25, 3, 3, 3,
+  350, 3, 3, 4, 3, 60, 3, 3, 3, 3, 3, 330, 4, 3, 3, 18, 3, 3, 3, 3
+};
+
+static uint32_t payload( uint32_t sequence, unsigned i)
+{
+  return sequence * 2654435761u + i;
+}
+
+struct replay_result_t
+{
+  unsigned overruns;
+  unsigned records_written;
+  unsigned records_lost;
+  unsigned max_pending;
+};
+
+/*!
+ 100 Hz producer against a consumer writing one slot at a time with latencies from the trace.
+ A slot is copied into the "file" when its write completes, so a slot overwritten
+ by the producer while still being written shows up as a corrupt record.
+ */
+static replay_result_t replay( const std::vector <unsigned> & trace, unsigned duration_ms, unsigned record_words = RECORD_WORDS)
+{
+  static uint32_t buffer[ BUFFER_WORDS];
+  log_slot_ring_t ring( buffer, BUFFER_WORDS, SLOTS);
+  std::vector <uint32_t> file;
+  replay_result_t result = { 0, 0, 0, 0};
+
+  uint32_t sequence = 0;
+  uint32_t * writing = 0;
+  unsigned busy_until = 0;
+  unsigned trace_index = 0;
+
+  for( unsigned now = 0; now < duration_ms * 1000; now += 1000)
+    {
+      if( now % TICK_USEC == 0) // producer
+	{
+	  if( ring.make_room( record_words))
+	    {
+	      log_span_t span = ring.reserve( record_words);
+	      for( unsigned i = 0; i < span.first_words; ++i)
+		span.first[i] = i ? payload( sequence, i) : sequence;
+	      for( unsigned i = 0; i < span.second_words; ++i)
+		span.second[i] = payload( sequence, span.first_words + i);
+	      ring.commit( record_words);
+	    }
+	  ++sequence;
+	}
+
+      if( writing && now >= busy_until) // consumer: write complete
+	{
+	  file.insert( file.end(), writing, writing + ring.get_slot_size_words());
+	  ring.release_slot();
+	  writing = 0;
+	}
+
+      if( ( writing == 0) && ( writing = ring.get_completed_slot()))
+	{
+	  if( ring.get_pending_slots() > result.max_pending)
+	    result.max_pending = ring.get_pending_slots();
+	  busy_until = now + trace[ trace_index++ % trace.size()] * 1000;
+	}
+    }
+
+  // records are dropped as a whole, never torn, and keep their order
+  uint32_t expected = 0;
+  for( unsigned record = 0; record + record_words <= file.size(); record += record_words)
+    {
+      uint32_t recorded = file[ record];
+      CHECK( recorded >= expected);
+      for( unsigned i = 1; i < record_words; ++i)
+	CHECK( file[ record + i] == payload( recorded, i));
+      result.records_lost += recorded - expected;
+      expected = recorded + 1;
+      ++result.records_written;
+    }
+
+  result.overruns = ring.get_overrun_count();
+  return result;
+}
+
+//! the ring covers card stalls of more than 300 ms without losing data
+static void test_stall_replay( void)
+{
+  std::vector <unsigned> trace( latency_trace_ms, latency_trace_ms + sizeof( latency_trace_ms) / sizeof( unsigned));
+  replay_result_t result = replay( trace, 60000);
+  printf( "stall replay: %u records written, %u lost, peak %u pending slots, %u overruns\n",
+	  result.records_written, result.records_lost, result.max_pending, result.overruns);
+  CHECK( result.overruns == 0);
+  CHECK( result.records_lost == 0);
+  CHECK( result.records_written == 6000); // the last slot is complete and written
+  CHECK( result.max_pending > 2);
+  CHECK( result.max_pending < SLOTS);
+}
+
+//! a stall longer than the whole buffer costs slots, but the logger keeps on running
+//! records crossing slot boundaries keep their part in the slot before
+static void test_overrun( void)
+{
+  std::vector <unsigned> trace( 100, 3);
+  trace[ 3] = 1500;
+  static const unsigned record_words[] = { RECORD_WORDS, 60, 100};
+  for( unsigned size : record_words)
+    {
+      replay_result_t result = replay( trace, 4000, size);
+      printf( "long stall, %u word records: %u written, %u lost, %u overruns\n",
+	      size, result.records_written, result.records_lost, result.overruns);
+      CHECK( result.overruns > 0);
+      CHECK( result.records_lost > 0);
+      // each overrun drops the records started within one slot, the open slot is not written
+      unsigned per_slot = BUFFER_WORDS / SLOTS / size + 1;
+      CHECK( result.records_lost <= result.overruns * per_slot);
+      CHECK( result.records_written + result.records_lost >= 400 - per_slot);
+    }
+}
+
+//! a record ending exactly at the slot end is checked like one crossing it
+static void test_exact_fit( void)
+{
+  uint32_t buffer[ 4 * 16];
+  log_slot_ring_t ring( buffer, 4 * 16, 4);
+
+  CHECK( ring.make_room( 16 - 1));
+  log_span_t span = ring.reserve( 16 - 1);
+  ring.commit( 16 - 1);
+  CHECK( ring.make_room( 1));
+  span = ring.reserve( 1); // exact fit, next slot free
+  CHECK( span.first == buffer + 15);
+  CHECK( span.first_words == 1);
+  CHECK( span.second_words == 0);
+  span.first[0] = 0x1234;
+  CHECK( ring.commit( 1));
+  CHECK( ring.get_pending_slots() == 1);
+  CHECK( ring.get_overrun_count() == 0);
+  CHECK( ring.get_position() == 16);
+
+  for( unsigned slot = 1; slot < 3; ++slot) // fill until no slot is left
+    {
+      CHECK( ring.make_room( 10));
+      ring.reserve( 10);
+      ring.commit( 10);
+      CHECK( ring.make_room( 6));
+      ring.reserve( 6);
+      CHECK( ring.commit( 6));
+    }
+  CHECK( ring.get_pending_slots() == 3);
+
+  CHECK( ring.make_room( 10));
+  ring.reserve( 10);
+  ring.commit( 10);
+  CHECK( ring.reserve( 6).first == 0); // exact fit, next slot still in use
+  CHECK( ring.make_room( 6)); // drop before writing
+  span = ring.reserve( 6);
+  CHECK( ring.get_overrun_count() == 1);
+  CHECK( span.first == buffer + 3 * 16);
+  CHECK( span.first_words == 6);
+  span.first[0] = 0x5678;
+  CHECK( not ring.commit( 6));
+  CHECK( ring.get_pending_slots() == 3);
+  CHECK( ring.get_position() == 3 * 16 + 6); // the record survives in the open slot
+  CHECK( ring.get_open_words() == 6);
+  CHECK( ring.get_open_slot()[0] == 0x5678);
+
+  CHECK( ring.get_completed_slot() == buffer);
+  CHECK( buffer[15] == 0x1234);
+  ring.release_slot();
+  CHECK( ring.get_completed_slot() == buffer + 16);
+}
+
+//! a record continued from the previous slot is kept when the records behind it are dropped
+static void test_record_across_slots( void)
+{
+  uint32_t buffer[ 3 * 16];
+  log_slot_ring_t ring( buffer, 3 * 16, 3);
+
+  for( unsigned record = 0; record < 4; ++record) // 4 * 10 words, slot ends within record 1 and 3
+    {
+      CHECK( ring.make_room( 10));
+      log_span_t span = ring.reserve( 10);
+      for( unsigned i = 0; i < span.first_words; ++i)
+	span.first[i] = record;
+      for( unsigned i = 0; i < span.second_words; ++i)
+	span.second[i] = record;
+      ring.commit( 10);
+    }
+  CHECK( ring.get_pending_slots() == 2);
+  CHECK( ring.get_open_words() == 8); // end of record 3
+
+  CHECK( ring.make_room( 5)); // record 4 fits
+  ring.reserve( 5); // and is written
+  ring.commit( 5);
+  CHECK( ring.make_room( 5)); // record 5 would need the next slot: drop record 4 only
+  CHECK( ring.get_overrun_count() == 1);
+  CHECK( ring.get_open_words() == 8);
+  CHECK( ring.get_open_slot()[7] == 3);
+
+  CHECK( ring.make_room( 7)); // room up to the slot end
+  CHECK( not ring.make_room( 8)); // would reach the slot end, nothing left to drop
+  CHECK( ring.get_overrun_count() == 2);
+  CHECK( ring.get_open_words() == 8);
+}
+
+/*!
+ BASIC_SENSOR_DATA sized records at 100 Hz: the former word by word copy with a
+ buffer boundary check per word against the span based write_block() path and
+ serialization straight into the reserved span.
+ */
+static void test_append_throughput( void)
+{
+  enum { RECORDS = 1000000 };
+  static uint32_t buffer[ BUFFER_WORDS];
+  uint32_t record[ RECORD_WORDS];
+  for( unsigned i = 0; i < RECORD_WORDS; ++i)
+    record[i] = payload( 1, i);
+  uint32_t check = 0;
+
+  // reference: the two half buffer write_block() of the first implementation
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  uint32_t * write_pointer = buffer;
+  uint32_t * second_part = buffer + BUFFER_WORDS / 2;
+  unsigned flushes = 0;
+  for( unsigned n = 0; n < RECORDS; ++n)
+    {
+      record[0] = n;
+      const uint32_t * p_data = record;
+      for( unsigned size_words = RECORD_WORDS; size_words--; )
+	{
+	  *write_pointer++ = *p_data++;
+	  if( write_pointer >= buffer + BUFFER_WORDS)
+	    {
+	      write_pointer = buffer;
+	      ++flushes;
+	    }
+	  else if( write_pointer == second_part)
+	    ++flushes;
+	}
+      check += write_pointer[ -1];
+    }
+  double word_copy = std::chrono::duration <double, std::nano> ( std::chrono::steady_clock::now() - start).count();
+
+  log_slot_ring_t ring( buffer, BUFFER_WORDS, SLOTS);
+  start = std::chrono::steady_clock::now();
+  for( unsigned n = 0; n < RECORDS; ++n)
+    {
+      record[0] = n;
+      ring.make_room( RECORD_WORDS);
+      log_span_t span = ring.reserve( RECORD_WORDS);
+      memcpy( span.first, record, span.first_words * sizeof( uint32_t));
+      if( span.second_words)
+	memcpy( span.second, record + span.first_words, span.second_words * sizeof( uint32_t));
+      ring.commit( RECORD_WORDS);
+      if( ring.get_completed_slot())
+	ring.release_slot();
+      check += span.first[0];
+    }
+  double span_copy = std::chrono::duration <double, std::nano> ( std::chrono::steady_clock::now() - start).count();
+
+  ring.reset();
+  start = std::chrono::steady_clock::now();
+  for( unsigned n = 0; n < RECORDS; ++n)
+    {
+      ring.make_room( RECORD_WORDS);
+      log_span_t span = ring.reserve( RECORD_WORDS);
+      span.first[0] = n; // fields are serialized one by one
+      for( unsigned i = 1; i < span.first_words; ++i)
+	span.first[i] = record[i];
+      for( unsigned i = 0; i < span.second_words; ++i)
+	span.second[i] = record[ span.first_words + i];
+      ring.commit( RECORD_WORDS);
+      if( ring.get_completed_slot())
+	ring.release_slot();
+      check += span.first[0];
+    }
+  double in_place = std::chrono::duration <double, std::nano> ( std::chrono::steady_clock::now() - start).count();
+
+  CHECK( ring.get_overrun_count() == 0);
+  CHECK( flushes == RECORDS * RECORD_WORDS / ( BUFFER_WORDS / 2));
+  printf( "append %u words: word copy %.1f ns, write_block %.1f ns, in place %.1f ns per record ( check %x)\n",
+	  (unsigned)RECORD_WORDS, word_copy / RECORDS, span_copy / RECORDS, in_place / RECORDS, check);
+}
+
+int main( void)
+{
+  test_stall_replay();
+  test_overrun();
+  test_exact_fit();
+  test_record_across_slots();
+  test_append_throughput();
+  return TEST_RESULT();
+}
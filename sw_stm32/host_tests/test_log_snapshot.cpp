@@ -0,0 +1,141 @@
+/***********************************************************************//**
+ * @file		test_log_snapshot.cpp
+ * @brief		log snapshot request and preparation counts
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#include "host_test.h"
+#include "log_snapshot.h"
+
+static void test_single_request( void)
+{
+  log_snapshot_sequence_t sequence;
+  sequence.request();
+  CHECK( not sequence.is_ready());
+  unsigned request = sequence.begin();
+  CHECK( not sequence.is_ready());
+  sequence.done( request);
+  CHECK( sequence.is_ready());
+  CHECK( sequence.is_ready()); // reading does not consume
+}
+
+//! a configuration change while the snapshot is prepared: the old one is never delivered
+static void test_request_during_preparation( void)
+{
+  log_snapshot_sequence_t sequence;
+  sequence.request();
+  unsigned request = sequence.begin();
+  sequence.request();
+  sequence.done( request);
+  CHECK( not sequence.is_ready());
+
+  request = sequence.begin(); // the task runs again, the semaphore has been signalled
+  sequence.done( request);
+  CHECK( sequence.is_ready());
+}
+
+//! several requests before the task runs: one preparation serves all of them
+static void test_coalesced_requests( void)
+{
+  log_snapshot_sequence_t sequence;
+  for( unsigned i = 0; i < 5; ++i)
+    sequence.request();
+  unsigned request = sequence.begin();
+  sequence.done( request);
+  CHECK( sequence.is_ready());
+}
+
+/*!
+ Communicator at 100 Hz changing the configuration at random ticks,
+ snapshot task woken by a binary semaphore, needing a few ticks per preparation.
+ Whenever the snapshot is reported ready it has to show the latest configuration.
+ */
+static void test_random_requests( void)
+{
+  log_snapshot_sequence_t sequence;
+  unsigned configuration = 0;	//!< EEPROM content version
+  unsigned snapshot = 0;	//!< version copied into the snapshot
+  bool semaphore = false;
+  bool preparing = false;
+  unsigned request = 0, copied = 0, busy_ticks = 0;
+  unsigned deliveries = 0, waits = 0, max_wait = 0, wait = 0;
+  bool pending = false;
+  uint32_t random = 12345;
+
+  for( unsigned tick = 0; tick < 100000; ++tick)
+    {
+      random = random * 1664525u + 1013904223u;
+      if( ( random >> 24) < 8) // about 3% of the ticks
+	{
+	  ++configuration;
+	  sequence.request();
+	  semaphore = true;
+	  pending = true;
+	}
+
+      if( pending)
+	{
+	  if( sequence.is_ready())
+	    {
+	      CHECK( snapshot == configuration);
+	      ++deliveries;
+	      pending = false;
+	      if( wait > max_wait)
+		max_wait = wait;
+	      wait = 0;
+	    }
+	  else
+	    {
+	      ++waits;
+	      ++wait;
+	    }
+	}
+
+      // low priority task: runs after the communicator
+      if( not preparing && semaphore)
+	{
+	  semaphore = false;
+	  preparing = true;
+	  request = sequence.begin();
+	  copied = configuration;
+	  busy_ticks = 1 + ( random >> 30);
+	}
+      if( preparing && ( --busy_ticks == 0))
+	{
+	  snapshot = copied;
+	  sequence.done( request);
+	  preparing = false;
+	}
+    }
+
+  CHECK( deliveries > 1000);
+  CHECK( not pending || preparing || semaphore);
+  CHECK( max_wait < 20);
+  printf( "snapshot: %u deliveries, %u ticks waited, longest wait %u ticks\n", deliveries, waits, max_wait);
+}
+
+int main( void)
+{
+  test_single_request();
+  test_request_during_preparation();
+  test_coalesced_requests();
+  test_random_requests();
+  return TEST_RESULT();
+}
@@ -0,0 +1,129 @@
+/***********************************************************************//**
+ * @file		test_published_copy.cpp
+ * @brief		published copy: publications interleaved with a reader
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#include "host_test.h"
+#include "published_copy.h"
+
+enum { FIELDS = 8};
+
+static void ( *copy_hook)( void) = 0;	//!< called by the reader in the middle of a copy
+
+//! all fields carry the same value, a torn copy has different ones
+struct sample_t
+{
+  unsigned field[ FIELDS];
+
+  sample_t( void)
+  {
+    for( unsigned i = 0; i < FIELDS; ++i)
+      field[i] = 0;
+  }
+
+  sample_t( const sample_t & right)
+  {
+    for( unsigned i = 0; i < FIELDS; ++i)
+      field[i] = right.field[i];
+  }
+
+  sample_t & operator = ( const sample_t & right)
+  {
+    for( unsigned i = 0; i < FIELDS / 2; ++i)
+      field[i] = right.field[i];
+    if( copy_hook)
+      {
+	void ( *hook)( void) = copy_hook;
+	copy_hook = 0; // the publications inside copy as well
+	hook();
+      }
+    for( unsigned i = FIELDS / 2; i < FIELDS; ++i)
+      field[i] = right.field[i];
+    return *this;
+  }
+};
+
+static published_copy_t < sample_t> published;
+static unsigned publications_in_hook;
+static unsigned hook_calls;
+
+static sample_t make_sample( unsigned value)
+{
+  sample_t sample;
+  for( unsigned i = 0; i < FIELDS; ++i)
+    sample.field[i] = value;
+  return sample;
+}
+
+static bool consistent( const sample_t & sample)
+{
+  for( unsigned i = 1; i < FIELDS; ++i)
+    if( sample.field[i] != sample.field[0])
+      return false;
+  return true;
+}
+
+static unsigned next_value = 1;
+
+//! writer task preempting the reader
+static void publish_in_between( void)
+{
+  ++hook_calls;
+  for( unsigned i = 0; i < publications_in_hook; ++i)
+    published.publish( make_sample( next_value++));
+}
+
+//! reader interrupted by 0 .. 3 publications: never torn, always the latest value
+static void test_interleaved( void)
+{
+  for( publications_in_hook = 0; publications_in_hook <= 3; ++publications_in_hook)
+    {
+      published.publish( make_sample( next_value++));
+      hook_calls = 0;
+      copy_hook = publish_in_between;
+      sample_t sample;
+      published.read( sample);
+      CHECK( hook_calls == 1);
+      CHECK( consistent( sample));
+      CHECK( sample.field[0] == next_value - 1);
+    }
+}
+
+//! the case the former check "publications - sequence > 1" accepted:
+//! two publications, the second one overwrites the buffer being read
+static void test_buffer_overwritten( void)
+{
+  published.publish( make_sample( 100));
+  next_value = 200;
+  publications_in_hook = 2;
+  copy_hook = publish_in_between;
+  sample_t sample;
+  published.read( sample);
+  CHECK( consistent( sample));
+  CHECK( sample.field[0] == 201);
+}
+
+int main( void)
+{
+  test_interleaved();
+  test_buffer_overwritten();
+  return TEST_RESULT();
+}
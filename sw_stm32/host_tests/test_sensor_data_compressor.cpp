@@ -0,0 +1,253 @@
+/***********************************************************************//**
+ * @file		test_sensor_data_compressor.cpp
+ * @brief		round trip of the sensor data compressor, with lost records
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#include "host_test.h"
+#include "sensor_data_compressor.h"
+#include <string.h>
+#include <math.h>
+#include <chrono>
+
+enum { CHANNELS = 8, RECORDS = 300, KEYFRAME_INTERVAL = 100};
+
+typedef sensor_data_compressor < CHANNELS, KEYFRAME_INTERVAL> compressor_t;
+typedef sensor_data_decompressor < CHANNELS> decompressor_t;
+
+//! slowly varying float channels like the logged observations
+static void make_sample( unsigned n, uint32_t * data)
+{
+  static uint32_t seed = 12345;
+  for( unsigned i = 0; i < CHANNELS; ++i)
+    {
+      seed = seed * 1664525 + 1013904223;
+      float value = (float)( i * 10.0 + n * 0.01 * ( i + 1)) + (float)( seed >> 24) * 1e-4f;
+      memcpy( data + i, &value, sizeof( uint32_t));
+    }
+}
+
+typedef struct
+{
+  uint32_t data[ CHANNELS];
+  uint32_t packed[ compressor_t::MAX_SIZE_WORDS];
+  unsigned size;
+} record_t;
+
+static record_t records[ RECORDS];
+
+//! @param restart_at force a keyframe at this record, as the communicator does after an overrun
+static void encode_all( unsigned restart_at = RECORDS)
+{
+  compressor_t compressor;
+  for( unsigned n = 0; n < RECORDS; ++n)
+    {
+      make_sample( n, records[n].data);
+      if( n == restart_at)
+	compressor.restart();
+      records[n].size = compressor.encode( records[n].data, records[n].packed);
+      CHECK( records[n].size <= compressor_t::MAX_SIZE_WORDS);
+    }
+}
+
+static bool is_keyframe( unsigned n)
+{
+  return records[n].packed[0] & COMPRESSOR_KEYFRAME_FLAG;
+}
+
+static void test_round_trip( void)
+{
+  encode_all();
+  CHECK( is_keyframe( 0));
+  CHECK( is_keyframe( KEYFRAME_INTERVAL));
+  CHECK( not is_keyframe( 1));
+
+  decompressor_t decompressor;
+  unsigned total_size = 0;
+  for( unsigned n = 0; n < RECORDS; ++n)
+    {
+      uint32_t data[ CHANNELS];
+      CHECK( decompressor.decode( records[n].packed, records[n].size, data));
+      CHECK( 0 == memcmp( data, records[n].data, sizeof( data)));
+      total_size += records[n].size;
+    }
+  CHECK( total_size < RECORDS * compressor_t::MAX_SIZE_WORDS); // it does compress
+}
+
+//! a lost delta record must not be decoded into wrong values
+static void test_sequence_gap( void)
+{
+  const unsigned lost = 150;
+  encode_all();
+  CHECK( not is_keyframe( lost));
+
+  decompressor_t decompressor;
+  for( unsigned n = 0; n < RECORDS; ++n)
+    {
+      if( n == lost)
+	continue;
+      uint32_t data[ CHANNELS];
+      bool decoded = decompressor.decode( records[n].packed, records[n].size, data);
+      bool expected = ( n < lost) || ( n >= 2 * KEYFRAME_INTERVAL); // resync at the next keyframe
+      CHECK( decoded == expected);
+      if( decoded)
+	CHECK( 0 == memcmp( data, records[n].data, sizeof( data)));
+    }
+}
+
+//! keyframe forced right behind the gap: only the lost record is missing
+static void test_restart_after_gap( void)
+{
+  const unsigned lost = 150;
+  encode_all( lost + 1);
+  CHECK( is_keyframe( lost + 1));
+
+  decompressor_t decompressor;
+  for( unsigned n = 0; n < RECORDS; ++n)
+    {
+      if( n == lost)
+	continue;
+      uint32_t data[ CHANNELS];
+      CHECK( decompressor.decode( records[n].packed, records[n].size, data));
+      CHECK( 0 == memcmp( data, records[n].data, sizeof( data)));
+    }
+}
+
+//! the 16 bit sequence number wraps around without a false gap
+static void test_sequence_wrap( void)
+{
+  compressor_t compressor;
+  decompressor_t decompressor;
+  unsigned failures = 0;
+  for( unsigned n = 0; n < 70000; ++n)
+    {
+      uint32_t data[ CHANNELS], packed[ compressor_t::MAX_SIZE_WORDS], decoded[ CHANNELS];
+      make_sample( n, data);
+      unsigned size = compressor.encode( data, packed);
+      if( not decompressor.decode( packed, size, decoded) || memcmp( data, decoded, sizeof( data)))
+	++failures;
+    }
+  CHECK( failures == 0);
+}
+
+enum { SENSOR_CHANNELS = 20, FLIGHT_RECORDS = 100 * 600};
+
+//! quantized sensor reading as the drivers deliver it: integer counts times the LSB weight
+static float quantize( double value, double lsb)
+{
+  return (float)( floor( value / lsb + 0.5) * lsb);
+}
+
+/*!
+ Ten minutes of circling flight at 100 Hz, channels like the logged sensor data:
+ acceleration, rotation rate, magnetic induction, static, pitot and absolute pressure,
+ temperatures and supply voltage, each with the LSB and noise of the sensor.
+ No flight log is part of this repository, so the data is synthesized.
+ */
+static void make_flight_sample( unsigned n, uint32_t * data)
+{
+  static uint32_t seed = 4711;
+  double t = n * 0.01;
+  double bank = 0.5 * sin( t * 0.02); // circling with changing bank angle
+  double turn = 2.0 * M_PI / 25.0 * ( 1.0 + 0.1 * sin( t * 0.05)); // 25 s per circle
+  double heading = turn * t;
+  float value[ SENSOR_CHANNELS];
+
+  double noise[ SENSOR_CHANNELS];
+  for( unsigned i = 0; i < SENSOR_CHANNELS; ++i)
+    {
+      seed = seed * 1664525 + 1013904223;
+      noise[i] = ( (int)( seed >> 20) - 2048) / 2048.0; // -1 .. 1
+    }
+
+  const double G = 9.81;
+  value[0] = quantize( 0.3 * sin( t * 1.3) + 0.05 * noise[0], G / 2048);		// acceleration
+  value[1] = quantize( 0.2 * sin( t * 0.7) + 0.05 * noise[1], G / 2048);
+  value[2] = quantize( -G / cos( bank) + 0.3 * sin( t * 2.1) + 0.05 * noise[2], G / 2048);
+  value[3] = quantize( 0.02 * sin( t * 3.0) + 0.002 * noise[3], M_PI / 180 / 16.4);	// rotation rate
+  value[4] = quantize( turn * sin( bank) + 0.002 * noise[4], M_PI / 180 / 16.4);
+  value[5] = quantize( turn * cos( bank) + 0.002 * noise[5], M_PI / 180 / 16.4);
+  value[6] = quantize( 0.2 * cos( heading) + 0.001 * noise[6], 1.0 / 6842);		// magnetic induction
+  value[7] = quantize( 0.2 * sin( heading) + 0.001 * noise[7], 1.0 / 6842);
+  value[8] = quantize( 0.45 + 0.001 * noise[8], 1.0 / 6842);
+  value[9] = quantize( 85000.0 - 1.5 * t + 0.5 * noise[9], 0.01);			// static pressure
+  value[10] = quantize( 750.0 + 30.0 * sin( t * 0.3) + 2.0 * noise[10], 0.01);	// pitot pressure
+  value[11] = quantize( 85000.0 - 1.5 * t + 1.0 * noise[11], 0.01);			// absolute pressure
+  value[12] = quantize( 12.0 - 0.001 * t + 0.02 * noise[12], 0.01);			// temperatures
+  value[13] = quantize( 25.0 + 0.0005 * t + 0.02 * noise[13], 0.01);
+  value[14] = quantize( 24.0 + 0.0005 * t + 0.02 * noise[14], 1.0 / 256);
+  value[15] = quantize( 12.6 - 0.0001 * t + 0.005 * noise[15], 0.001);		// supply voltage
+  value[16] = quantize( 0.6 + 0.01 * noise[16], 0.001);				// humidity
+  value[17] = 0.0f;								// unused channels
+  value[18] = 0.0f;
+  value[19] = quantize( 1.0, 1.0);
+  memcpy( data, value, sizeof( value));
+}
+
+//! compression ratio and speed on flight like data, every record restored bit by bit
+static void test_flight_data( void)
+{
+  typedef sensor_data_compressor < SENSOR_CHANNELS> flight_compressor_t;
+  static uint32_t raw[ FLIGHT_RECORDS][ SENSOR_CHANNELS];
+  static uint32_t packed[ FLIGHT_RECORDS][ flight_compressor_t::MAX_SIZE_WORDS];
+  static unsigned size[ FLIGHT_RECORDS];
+
+  for( unsigned n = 0; n < FLIGHT_RECORDS; ++n)
+    make_flight_sample( n, raw[n]);
+
+  flight_compressor_t compressor;
+  unsigned total_size = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for( unsigned n = 0; n < FLIGHT_RECORDS; ++n)
+    {
+      size[n] = compressor.encode( raw[n], packed[n]);
+      total_size += size[n];
+    }
+  double encode_time = std::chrono::duration <double> ( std::chrono::steady_clock::now() - start).count();
+
+  sensor_data_decompressor < SENSOR_CHANNELS> decompressor;
+  unsigned failures = 0;
+  start = std::chrono::steady_clock::now();
+  for( unsigned n = 0; n < FLIGHT_RECORDS; ++n)
+    {
+      uint32_t data[ SENSOR_CHANNELS];
+      if( not decompressor.decode( packed[n], size[n], data) || memcmp( data, raw[n], sizeof( data)))
+	++failures;
+    }
+  double decode_time = std::chrono::duration <double> ( std::chrono::steady_clock::now() - start).count();
+  CHECK( failures == 0);
+
+  // the raw record carries no sequence word, the log record framing is the same for both
+  double ratio = (double)( FLIGHT_RECORDS * SENSOR_CHANNELS) / total_size;
+  double megabytes = FLIGHT_RECORDS * SENSOR_CHANNELS * sizeof( uint32_t) / 1e6;
+  printf( "flight data: ratio %.2f, %.1f words per record, encode %.0f MB/s, decode %.0f MB/s\n",
+	  ratio, (double)total_size / FLIGHT_RECORDS, megabytes / encode_time, megabytes / decode_time);
+  CHECK( ratio > 1.5); // sensor noise in the low mantissa bits limits XOR compression
+}
+
+int main( void)
+{
+  test_flight_data();
+  test_round_trip();
+  test_sequence_gap();
+  test_restart_after_gap();
+  test_sequence_wrap();
+  return TEST_RESULT();
+}
@@ -0,0 +1,172 @@
+/***********************************************************************//**
+ * @file		test_sync_policy.cpp
+ * @brief		sync policy against simulated uSD card latency traces
+ * @author		Dr. Klaus Schaefer
+ * @copyright 		Copyright 2026 Dr. Klaus Schaefer. All rights reserved.
+ * @license 		This project is released under the GNU Public License GPL-3.0
+
+    <Larus Flight Sensor Firmware>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ **************************************************************************/
+#include "host_test.h"
+#include "sync_policy.h"
+
+enum
+{
+  SLOTS = 8,		//!< LOG_BUFFER_SLOTS
+  MAX_INTERVAL = 16,	//!< LOG_SYNC_MAX_LOSS_KB / slot size
+  SLOT_PERIOD = 80000,	//!< usec to fill one 2 KB slot
+  DURATION = 600000000	//!< 10 minutes
+};
+
+//! card latency trace: write time per slot and f_sync time, both in usec
+struct card_trace_t
+{
+  const uint32_t * write;
+  unsigned write_length;
+  const uint32_t * sync;
+  unsigned sync_length;
+};
+
+struct trace_result_t
+{
+  unsigned syncs;
+  unsigned max_distance;	//!< slots written between two syncs
+  unsigned max_batch;		//!< slots written by one flush
+  unsigned overruns;
+  unsigned final_interval;
+};
+
+/*!
+ uSD task loop as in uSD_handler_runnable(): flush all completed slots,
+ then ask the policy. The producer completes a slot every SLOT_PERIOD
+ and loses it if the ring buffer is full.
+ */
+static trace_result_t replay( const card_trace_t & card)
+{
+  sync_policy_t policy( SLOTS, MAX_INTERVAL);
+  trace_result_t result = { 0, 0, 0, 0, 0};
+  uint64_t now = 1;
+  uint64_t next_slot_time = SLOT_PERIOD;
+  unsigned produced = 0, flushed = 0, distance = 0;
+  unsigned write_index = 0, sync_index = 0;
+
+  while( now < DURATION)
+    {
+      while( next_slot_time <= now) // producer
+	{
+	  if( produced - flushed >= SLOTS - 1)
+	    ++result.overruns;
+	  else
+	    ++produced;
+	  next_slot_time += SLOT_PERIOD;
+	}
+      if( produced == flushed)
+	{
+	  now = next_slot_time;
+	  continue;
+	}
+
+      uint64_t start = now;
+      unsigned batch = produced - flushed;
+      now += batch * card.write[ write_index++ % card.write_length];
+      flushed = produced;
+      policy.record_flush( now - start, batch, now);
+      distance += batch;
+      if( batch > result.max_batch)
+	result.max_batch = batch;
+
+      while( next_slot_time <= now) // produced while writing
+	{
+	  if( produced - flushed >= SLOTS - 1)
+	    ++result.overruns;
+	  else
+	    ++produced;
+	  next_slot_time += SLOT_PERIOD;
+	}
+
+      bool due = policy.sync_due( produced - flushed);
+      if( distance >= MAX_INTERVAL)
+	CHECK( due); // data loss limit
+      if( due)
+	{
+	  if( distance > result.max_distance)
+	    result.max_distance = distance;
+	  uint32_t duration = card.sync[ sync_index++ % card.sync_length];
+	  now += duration;
+	  policy.record_sync( duration);
+	  distance = 0;
+	  ++result.syncs;
+	}
+    }
+  result.final_interval = policy.get_interval();
+  return result;
+}
+
+static void report( const char * name, const trace_result_t & result)
+{
+  printf( "%s: %u syncs, interval %u, max distance %u, max batch %u, %u overruns\n",
+	  name, result.syncs, result.final_interval, result.max_distance, result.max_batch, result.overruns);
+}
+
+//! fast card: frequent syncs, little data at risk
+static void test_fast_card( void)
+{
+  static const uint32_t write[] = { 2500, 3000, 2800};
+  static const uint32_t sync[] = { 8000, 12000, 9000, 15000};
+  card_trace_t card = { write, 3, sync, 4};
+  trace_result_t result = replay( card);
+  report( "fast card", result);
+  CHECK( result.overruns == 0);
+  CHECK( result.final_interval <= 2);
+  CHECK( result.syncs > DURATION / SLOT_PERIOD / 3);
+  CHECK( result.max_distance <= MAX_INTERVAL); // before the first measurements
+}
+
+//! slow f_sync: syncs are spread, but never further than the loss limit
+static void test_slow_sync( void)
+{
+  static const uint32_t write[] = { 4000, 6000, 5000, 20000};
+  static const uint32_t sync[] = { 180000, 220000, 250000, 150000, 240000};
+  card_trace_t card = { write, 4, sync, 5};
+  trace_result_t result = replay( card);
+  report( "slow sync", result);
+  CHECK( result.overruns == 0);
+  CHECK( result.final_interval > 8);
+  CHECK( result.final_interval <= MAX_INTERVAL);
+  CHECK( result.max_distance < MAX_INTERVAL + result.max_batch);
+}
+
+//! syncs longer than the ring buffer covers: the loss limit wins over the overrun
+static void test_stalling_card( void)
+{
+  static const uint32_t write[] = { 5000, 5000, 300000, 5000, 5000, 5000};
+  static const uint32_t sync[] = { 700000, 100000, 650000};
+  card_trace_t card = { write, 6, sync, 3};
+  trace_result_t result = replay( card);
+  report( "stalling card", result);
+  CHECK( result.overruns > 0);
+  CHECK( result.final_interval == MAX_INTERVAL);
+  CHECK( result.max_distance < MAX_INTERVAL + result.max_batch);
+}
+
+int main( void)
+{
+  test_fast_card();
+  test_slow_sync();
+  test_stalling_card();
+  return TEST_RESULT();
+}